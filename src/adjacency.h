@@ -0,0 +1,372 @@
+#ifndef ADJACENCY_H
+#define ADJACENCY_H
+
+#include "utils/graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Adjacency views the coloring kernels are templated on
+ *
+ * A view exposes degree(v), an upper bound of the number of neighbors of v, and
+ * visit(v, f), which calls f on every neighbor of v until f returns true. The kernels
+ * only walk rows front to back and do not depend on the order of the neighbors, so a
+ * view is free to store them in any sequential encoding.
+ */
+namespace Adjacency
+{
+	/**
+	 * @brief Plain CSR, borrowed from the caller
+	 */
+	struct Csr
+	{
+		edge_t *row;
+		vertex_t *col;
+
+		inline edge_t degree(int v) const { return row[v + 1] - row[v]; }
+
+		template <typename F>
+		inline bool visit(int v, F f) const
+		{
+			for (edge_t j = row[v]; j < row[v + 1]; j++)
+				if (f(col[j]))
+					return true;
+			return false;
+		}
+	};
+
+	/**
+	 * @brief Delta and varint encoded CSR
+	 *
+	 * Every row is its degree, the first neighbor as a zigzag offset from the row id, then
+	 * the gaps between consecutive neighbors, each one as a little-endian base-128 varint.
+	 * Neighbors of a sorted row are close together, so most edges take one byte instead of four.
+	 * Rows are located through a skip pointer per block of 64 rows plus a 32-bit offset within
+	 * the block, so any row is reached without decoding others for about 4 bytes per vertex.
+	 */
+	class Compressed
+	{
+	public:
+		/**
+		 * @brief Encode a CSR graph in parallel, every row must be sorted
+		 *
+		 * @param row: row pointer
+		 * @param col: column pointer
+		 * @param n_vertex: number of vertices
+		 */
+		Compressed(edge_t *row, vertex_t *col, vertex_t n_vertex) : n_vertex(n_vertex)
+		{
+			uint64_t *offset = new uint64_t[n_vertex + 1];
+			int n_block = (n_vertex + BLOCK - 1) / BLOCK;
+
+			// row sizes, then their prefix sum, then the rows themselves
+			offset[0] = 0;
+			#pragma omp parallel for schedule(dynamic, 1024)
+			for (int v = 0; v < n_vertex; v++)
+				offset[v + 1] = encode_row(v, row, col, nullptr);
+
+			for (int v = 0; v < n_vertex; v++)
+				offset[v + 1] += offset[v];
+
+			block = new uint64_t[n_block + 1];
+			within = new uint32_t[n_vertex];
+			for (int b = 0; b <= n_block; b++)
+				block[b] = offset[std::min(b * BLOCK, (int)n_vertex)];
+			for (int v = 0; v < n_vertex; v++)
+			{
+				if (offset[v + 1] - block[v / BLOCK] > UINT32_MAX)
+				{
+					delete[] offset;
+					delete[] within;
+					delete[] block;
+					throw std::length_error("compressed block of rows exceeds 4 GiB");
+				}
+				within[v] = offset[v] - block[v / BLOCK];
+			}
+
+			data = new uint8_t[offset[n_vertex] + 1];
+			#pragma omp parallel for schedule(dynamic, 1024)
+			for (int v = 0; v < n_vertex; v++)
+				encode_row(v, row, col, data + offset[v]);
+			delete[] offset;
+		}
+
+		~Compressed()
+		{
+			delete[] data;
+			delete[] within;
+			delete[] block;
+		}
+
+		Compressed(const Compressed &) = delete;
+		Compressed &operator=(const Compressed &) = delete;
+
+		inline edge_t degree(int v) const
+		{
+			const uint8_t *p = start(v);
+			return (edge_t)read(p);
+		}
+
+		template <typename F>
+		inline bool visit(int v, F f) const
+		{
+			const uint8_t *p = start(v);
+			uint64_t deg = read(p);
+			if (deg == 0)
+				return false;
+
+			uint64_t z = read(p);
+			int64_t u = v + (int64_t)((z >> 1) ^ -(z & 1));
+			if (f((int)u))
+				return true;
+			for (uint64_t k = 1; k < deg; k++)
+			{
+				u += read(p);
+				if (f((int)u))
+					return true;
+			}
+			return false;
+		}
+
+		/**
+		 * @brief Bytes taken by the encoded rows and their offsets
+		 */
+		inline uint64_t bytes() const
+		{
+			int n_block = (n_vertex + BLOCK - 1) / BLOCK;
+			return block[n_block] + sizeof(uint64_t) * (n_block + 1) + sizeof(uint32_t) * n_vertex;
+		}
+
+	private:
+		static constexpr int BLOCK = 64;
+
+		vertex_t n_vertex;
+		// skip pointer of every block of rows, and offset of every row within its block
+		uint64_t *block;
+		uint32_t *within;
+		uint8_t *data;
+
+		inline const uint8_t *start(int v) const { return data + block[v / BLOCK] + within[v]; }
+
+		static inline uint64_t read(const uint8_t *&p)
+		{
+			uint64_t x = *p++;
+			if (x < 0x80)
+				return x;
+			x &= 0x7f;
+			for (int shift = 7;; shift += 7)
+			{
+				uint8_t b = *p++;
+				x |= (uint64_t)(b & 0x7f) << shift;
+				if (b < 0x80)
+					return x;
+			}
+		}
+
+		// writes x at out unless out is nullptr, returns the number of bytes either way
+		static inline int write(uint64_t x, uint8_t *out)
+		{
+			int n = 1;
+			for (; x >= 0x80; x >>= 7, n++)
+				if (out)
+					*out++ = (uint8_t)(x | 0x80);
+			if (out)
+				*out = (uint8_t)x;
+			return n;
+		}
+
+		static uint64_t encode_row(int v, edge_t *row, vertex_t *col, uint8_t *out)
+		{
+			uint64_t n = write(row[v + 1] - row[v], out);
+			for (edge_t j = row[v]; j < row[v + 1]; j++)
+			{
+				int64_t delta = j == row[v] ? (int64_t)col[j] - v : (int64_t)col[j] - col[j - 1];
+				uint64_t z = j == row[v] ? ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63) : (uint64_t)delta;
+				n += write(z, out ? out + n : nullptr);
+			}
+			return n;
+		}
+	};
+
+	/**
+	 * @brief Distance-2 neighborhoods of a base view, its distance-1 coloring is a distance-2 coloring of the base
+	 *
+	 * Rows of the square graph are deduplicated, sorted and stored block by block of vertices
+	 * as long as they fit in a memory budget. Rows of the blocks left out are walked through the
+	 * base view on the fly, with a set sized by the paths of the row filtering the vertices
+	 * reached twice, so every neighbor is visited once either way. A walk holds memory in
+	 * proportion to its row, not to the graph, which the budget leaves out. Visits must not be
+	 * nested, which the distance-1 kernels never do.
+	 */
+	template <typename G>
+	class Square
+	{
+	public:
+		/**
+		 * @brief Count the square rows in parallel, then store the blocks that fit in budget
+		 *
+		 * @param g: base view, must outlive the square
+		 * @param n_vertex: number of vertices
+		 * @param budget: bytes the stored rows and their offsets may take
+		 */
+		Square(const G &g, vertex_t n_vertex, uint64_t budget) : g(g), n_vertex(n_vertex)
+		{
+			int n_block = (n_vertex + BLOCK - 1) / BLOCK;
+			offset = new uint64_t[n_vertex + 1];
+			stored = new bool[n_block];
+
+			offset[0] = 0;
+			#pragma omp parallel for schedule(dynamic, 256)
+			for (int v = 0; v < n_vertex; v++)
+			{
+				uint64_t deg = 0;
+				walk(v, [&](int) { deg++; return false; });
+				offset[v + 1] = deg;
+			}
+
+			// blocks are stored first come first served, a block too large for what is left is skipped
+			uint64_t left = budget < sizeof(uint64_t) * (n_vertex + 1) ? 0 : budget - sizeof(uint64_t) * (n_vertex + 1);
+			n_stored = 0;
+			for (int b = 0; b < n_block; b++)
+			{
+				uint64_t size = 0;
+				for (int v = b * BLOCK; v < std::min((b + 1) * BLOCK, (int)n_vertex); v++)
+					size += sizeof(vertex_t) * offset[v + 1];
+				stored[b] = size <= left;
+				if (stored[b])
+				{
+					left -= size;
+					n_stored++;
+				}
+			}
+
+			for (int v = 0; v < n_vertex; v++)
+				offset[v + 1] = offset[v] + (stored[v / BLOCK] ? offset[v + 1] : 0);
+
+			col = new vertex_t[offset[n_vertex] + 1];
+			#pragma omp parallel for schedule(dynamic, 256)
+			for (int v = 0; v < n_vertex; v++)
+			{
+				if (!stored[v / BLOCK])
+					continue;
+				uint64_t k = offset[v];
+				walk(v, [&](int u) { col[k++] = u; return false; });
+				std::sort(col + offset[v], col + offset[v + 1]);
+			}
+		}
+
+		~Square()
+		{
+			delete[] col;
+			delete[] stored;
+			delete[] offset;
+		}
+
+		Square(const Square &) = delete;
+		Square &operator=(const Square &) = delete;
+
+		inline edge_t degree(int v) const
+		{
+			if (stored[v / BLOCK])
+				return offset[v + 1] - offset[v];
+
+			// every path of length at most two, vertices reached twice included
+			edge_t deg = g.degree(v);
+			g.visit(v, [&](int u)
+			{
+				deg += g.degree(u);
+				return false;
+			});
+			return deg;
+		}
+
+		template <typename F>
+		inline bool visit(int v, F f) const
+		{
+			if (!stored[v / BLOCK])
+				return walk(v, f);
+
+			for (uint64_t j = offset[v]; j < offset[v + 1]; j++)
+				if (f(col[j]))
+					return true;
+			return false;
+		}
+
+		/**
+		 * @brief Bytes taken by the stored rows and their offsets
+		 */
+		inline uint64_t bytes() const { return sizeof(vertex_t) * offset[n_vertex] + sizeof(uint64_t) * (n_vertex + 1); }
+
+		/**
+		 * @brief Number of blocks of BLOCK vertices whose rows are stored, out of (n_vertex + BLOCK - 1) / BLOCK
+		 */
+		inline int stored_blocks() const { return n_stored; }
+
+		static constexpr int BLOCK = 1024;
+
+	private:
+		const G &g;
+		vertex_t n_vertex;
+		int n_stored;
+		// row offsets, empty for the rows of blocks that are not stored
+		uint64_t *offset;
+		vertex_t *col;
+		bool *stored;
+
+		// slots of the set walk keeps per thread, the rows of hubs take a set of their own for the walk
+		static constexpr size_t WALK_KEEP = 1 << 16;
+
+		// the distance-2 neighborhood of v through the base view, each vertex once
+		template <typename F>
+		bool walk(int v, F f) const
+		{
+			// the paths of length at most two bound the vertices reached, and size an open addressing
+			// set, so what a walk holds follows its row rather than the number of vertices
+			uint64_t bound = 1 + (uint64_t)g.degree(v);
+			g.visit(v, [&](int u)
+			{
+				bound += g.degree(u);
+				return false;
+			});
+			bound = std::min<uint64_t>(bound, n_vertex);
+			int bits = 4;
+			while (((size_t)1 << bits) < 2 * bound)
+				bits++;
+			size_t cap = (size_t)1 << bits, mask = cap - 1;
+
+			static thread_local std::vector<int> kept;
+			std::vector<int> own;
+			std::vector<int> &set = cap <= WALK_KEEP ? kept : own;
+			if (set.size() < cap)
+				set.resize(cap);
+			std::fill_n(set.begin(), cap, -1);
+
+			// true if u was not in the set yet
+			auto insert = [&](int u)
+			{
+				size_t h = (size_t)(((uint64_t)(unsigned int)u * 0x9e3779b97f4a7c15ULL) >> (64 - bits));
+				while (set[h] != -1)
+				{
+					if (set[h] == u)
+						return false;
+					h = (h + 1) & mask;
+				}
+				set[h] = u;
+				return true;
+			};
+
+			insert(v);
+			auto once = [&](int u) { return insert(u) && f(u); };
+			return g.visit(v, [&](int u)
+			{
+				return once(u) || g.visit(u, once);
+			});
+		}
+	};
+}
+
+#endif
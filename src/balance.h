@@ -0,0 +1,241 @@
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include "utils/graph.h"
+#include "utils/colorset.h"
+#include "greedy.h"
+#include "report.h"
+
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+// most rounds of the class balancing, nearly every move happens in the first two
+#define BALANCE_ROUNDS 8
+
+/**
+ * @brief Post-pass that evens out the color class sizes of a coloring without adding colors
+ *
+ * First fit fills the small colors first, so the first classes are large and the last ones
+ * hold a handful of vertices, and a consumer that runs one parallel phase per class idles
+ * on the small ones.
+ */
+namespace Balance
+{
+	/**
+	 * @brief Move vertices of over-full classes into under-full ones, in parallel rounds
+	 *
+	 * A class is over-full above ceil(n_vertex / n_color) vertices and under-full below. Each
+	 * round, every vertex of an over-full class moves to the emptiest under-full class none of
+	 * its neighbors has, as long as its class stays at the target and the new one does not pass
+	 * it, both enforced on the class sizes with atomics on chunks of slots held per thread. Two neighbors moving into the same class
+	 * at once are the only possible conflict, the smaller id goes back to its former class, which
+	 * nobody moved into since over- and under-full classes are disjoint within a round. Rounds
+	 * go on until nothing moves or max_round is reached.
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: valid coloring shaped (n_vertex, ), colors below n_color, balanced in place
+	 * @param n_color: number of colors, never exceeded
+	 * @param max_round: most rounds to run
+	 * @return n_moved is the number of vertices moved, n_conflict is 0, class_imbalance is measured after balancing
+	 */
+	template <int distance, typename G>
+	report balance(const G &g, vertex_t n_vertex, int colormap[], int n_color, int max_round = BALANCE_ROUNDS)
+	{
+		report result;
+		double t_start, t_end;
+		int round = 0;
+		int n_moved = 0, n_round_moved = 0, n_round_tried = 0;
+		bool done = n_color <= 1;
+		vertex_t target = n_color > 0 ? (n_vertex + n_color - 1) / n_color : 0;
+
+		std::vector<vertex_t> size(n_color);
+		std::vector<int> under;
+		std::vector<char> over(n_color);
+		// round + 1 in which each vertex last moved, 0 if never
+		int *moved = new int[n_vertex]();
+		Profile profile(omp_get_max_threads());
+
+		t_start = omp_get_wtime();
+		#pragma omp parallel
+		{
+			ColorSet forbidden(n_color);
+			std::vector<std::pair<int, int>> local;
+			std::vector<std::pair<int, int>> back;
+			double t_phase = omp_get_wtime();
+
+			// slots in under-full classes and departures from over-full ones this thread holds, so that
+			// the class sizes, the hub class above all, are updated once per chunk rather than per move
+			std::vector<vertex_t> slot(n_color), leave(n_color);
+			std::vector<int> open;
+			std::vector<char> closed(n_color);
+			vertex_t chunk = std::clamp<vertex_t>(target / (4 * omp_get_num_threads()), 1, 64);
+			auto reserve = [&](int k, int sign)
+			{
+				vertex_t s;
+				// read first, classes at the target are not hammered with atomics
+				#pragma omp atomic read
+				s = size[k];
+				if (sign * (s - target) >= 0)
+					return (vertex_t)0;
+				#pragma omp atomic capture
+				{
+					size[k] += sign * chunk;
+					s = size[k];
+				}
+				// what goes past the target is given back
+				vertex_t excess = std::min(chunk, std::max<vertex_t>(sign * (s - target), 0));
+				if (excess)
+				{
+					#pragma omp atomic
+					size[k] -= sign * excess;
+				}
+				return chunk - excess;
+			};
+
+			std::vector<vertex_t> count(n_color);
+			#pragma omp for nowait
+			for (vertex_t v = 0; v < n_vertex; v++)
+				count[colormap[v]]++;
+			for (int c = 0; c < n_color; c++)
+				if (count[c])
+				{
+					#pragma omp atomic
+					size[c] += count[c];
+				}
+			profile.record("classes", 0, n_vertex, t_phase, 0);
+			#pragma omp barrier
+
+			while (!done)
+			{
+				// under-full classes, the emptiest tried first
+				#pragma omp single
+				{
+					under.clear();
+					for (int c = 0; c < n_color; c++)
+					{
+						if (size[c] < target)
+							under.push_back(c);
+						over[c] = size[c] > target;
+					}
+					std::sort(under.begin(), under.end(), [&](int a, int b) { return size[a] < size[b]; });
+					n_round_moved = 0;
+					n_round_tried = 0;
+				}
+
+				// classes this thread found at the target, within a round they never reopen
+				t_phase = omp_get_wtime();
+				long long n_edge = 0;
+				local.clear();
+				open = under;
+				std::fill(closed.begin(), closed.end(), 0);
+				#pragma omp for schedule(dynamic, 256) nowait
+				for (vertex_t v = 0; v < n_vertex; v++)
+				{
+					int c = colormap[v];
+					if (!over[c] || closed[c] || open.empty())
+						continue;
+
+					forbidden.clear();
+					Greedy::visit_neighbors<distance>(v, g, [&](int u)
+					{
+						n_edge++;
+						int k;
+						#pragma omp atomic read
+						k = colormap[u];
+						forbidden.insert(k);
+						return false;
+					});
+
+					for (size_t i = 0; i < open.size(); i++)
+					{
+						int k = open[i];
+						if (forbidden.contains(k))
+							continue;
+						if (slot[k] == 0 && (slot[k] = reserve(k, 1)) == 0)
+						{
+							open.erase(open.begin() + i--);
+							continue;
+						}
+						if (leave[c] == 0 && (leave[c] = reserve(c, -1)) == 0)
+						{
+							closed[c] = 1;
+							break;
+						}
+						slot[k]--;
+						leave[c]--;
+						#pragma omp atomic write
+						colormap[v] = k;
+						moved[v] = round + 1;
+						local.push_back({v, c});
+						break;
+					}
+				}
+
+				// hand back what is left of the stock
+				for (int k = 0; k < n_color; k++)
+				{
+					if (slot[k] || leave[k])
+					{
+						#pragma omp atomic
+						size[k] += leave[k] - slot[k];
+					}
+					slot[k] = leave[k] = 0;
+				}
+				profile.record("move", round, n_vertex, t_phase, n_edge);
+				#pragma omp atomic
+				n_round_tried += (int)local.size();
+				#pragma omp barrier
+
+				// neighbors that moved into the same class at once, the smaller id gives way
+				t_phase = omp_get_wtime();
+				n_edge = 0;
+				back.clear();
+				for (const std::pair<int, int> &m : local)
+				{
+					int v = m.first, k = colormap[v];
+					if (Greedy::visit_neighbors<distance>(v, g, [&](int u)
+					{
+						n_edge++;
+						return colormap[u] == k && moved[u] == round + 1 && v < u;
+					}))
+						back.push_back(m);
+				}
+				profile.record("undo", round, n_round_tried, t_phase, n_edge);
+				#pragma omp barrier
+
+				for (const std::pair<int, int> &m : back)
+				{
+					#pragma omp atomic
+					size[colormap[m.first]]--;
+					#pragma omp atomic
+					size[m.second]++;
+					colormap[m.first] = m.second;
+				}
+				#pragma omp atomic
+				n_round_moved += (int)(local.size() - back.size());
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					n_moved += n_round_moved;
+					done = n_round_moved == 0 || ++round == max_round;
+				}
+			}
+		}
+		t_end = omp_get_wtime();
+
+		delete[] moved;
+		result.n_color = n_color;
+		result.t_exec = t_end - t_start;
+		result.n_conflict = 0;
+		result.n_moved = n_moved;
+		result.phases = profile.phases();
+		result.class_imbalance =
+			n_vertex > 0 && n_color > 0 ? (double)*std::max_element(size.begin(), size.end()) * n_color / n_vertex : 1;
+		return result;
+	}
+}
+
+#endif
@@ -1,26 +1,26 @@
 #include "utils/graphio.h"
+#include "utils/colorio.h"
 #include "utils/graph.h"
-
+#include "utils/perf.h"
+#include "adjacency.h"
+#include "report.h"
+#include "output.h"
+#include "engine.h"
+#include "ordering.h"
+#include "reorder.h"
+
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <iomanip>
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <unordered_set>
+#include <vector>
 #include <omp.h>
-
-/**
- * @brief Report wrapper for result and performance.
- *
- * @param t_exec Execution time
- * @param n_color Number of colors
- * @param n_conflict Number of conflicts
- */
-typedef struct report
-{
-	double t_exec;
-	int n_color;
-	int n_conflict;
-} report;
+#include <sched.h>
+#include <unistd.h>
 
 void print_header()
 {
@@ -44,284 +44,565 @@ void print_report(int n_thread, report r, std::string note, int conflicts)
 		   conflicts);
 }
 
-inline int max(vertex_t len, int colormap[])
+/**
+ * @brief Per-phase breakdown of a run, printed under its row of the table
+ */
+void print_phases(const report &r)
 {
-	int val = -1;
-	for (int i = 0; i < len; i++)
-		if (colormap[i] > val)
-			val = colormap[i];
-	return val + 1;
+	for (const phase &p : r.phases)
+		printf("   %-7s round %-4d | %12.10f s | %10lld vertices | %12lld edges | busy max %.10f mean %.10f s"
+			   " | idle mean %.10f s | imbalance %.2f\n",
+			   p.name, p.round, p.t_wall, p.n_vertex, p.n_edge, p.t_busy_max, p.t_busy_mean,
+			   p.t_idle_mean(), p.imbalance());
 }
 
-namespace D2Coloring
+/**
+ * @brief Summary of the times of repeated runs, printed under their row of the table
+ */
+void print_timing(const timing &t)
 {
-	/**
-	 * @brief Find number of conflicts in the graph
-	 * 
-	 * @param row: row pointer
-	 * @param col: column pointer
-	 * @param n_vertex: number of vertices
-	 * @param colormap: color array shaped (n_vertex, )
-	 * @param heatmap: map to track detected conflicts
-	 * @param conflict_vid: output array to store conflicted vertices
-	*/
-	int detect_conflicts(edge_t *row, vertex_t *col, vertex_t n_vertex, int colormap[], bool heatmap[], int conflict_vid[])
-	{
-		unsigned int count = 0;
-		#pragma omp parallel for
-		for (int i = 0; i < n_vertex; i++)
-		{
-			int c = colormap[i];
-			int vid, temp;
-			for (int j = row[i]; j < row[i + 1]; j++)
-			{
-				if (colormap[col[j]] == c)
-				{
-					vid = i < col[j] ? i : col[j];
-					if (!heatmap[vid])
-					{
-						heatmap[vid] = true;
-						#pragma omp atomic capture
-						temp = count++;
-						conflict_vid[temp] = vid;
-					}
-				}
-
-				for (int k = row[col[j]]; k < row[col[j] + 1]; k++)
-				{
-					if (colormap[col[k]] == c && col[k] != i)
-					{
-						vid = i < col[k] ? i : col[k];
-						if (!heatmap[vid])
-						{
-							heatmap[vid] = true;
-							#pragma omp atomic capture
-							temp = count++;
-							conflict_vid[temp] = vid;
-						}
-					}
-				}
-			}
-		}
+	printf("   time         | min %.10f s | median %.10f s | p95 %.10f s | mean %.10f +- %.10f s (95%% CI) | %d runs\n",
+		   t.t_min, t.t_median, t.t_p95, t.t_mean, t.t_ci95, t.n_run);
+}
+
+/**
+ * @brief Colors of a run before its iterated greedy recolorings, printed under its row of the table
+ */
+void print_iterated(const report &r, int n_color, int n_iteration)
+{
+	printf("   iterated     | %d colors before %d iterations, %d after\n", n_color, n_iteration, r.n_color);
+}
 
-		#pragma omp parallel for
-		for (edge_t e = 0; e < count; e++)
-			heatmap[conflict_vid[e]] = false;
+/**
+ * @brief Color class sizes of a run, printed under its row of the table
+ */
+void print_classes(const report &r)
+{
+	if (r.n_moved < 0)
+		printf("   classes      | largest over mean %.2f\n", r.class_imbalance);
+	else
+		printf("   classes      | largest over mean %.2f | %d vertices moved by balancing\n", r.class_imbalance, r.n_moved);
+}
 
-		return count;
-	}
+/**
+ * @brief Hardware counters of the coloring kernel of a run, printed under its row of the table
+ *
+ * @param n_edge: edges the kernel traversed, recoloring and balancing excluded as the counters are
+ * @param value: counts of the kernel, see PerfCounters
+ */
+void print_counters(long long n_edge, const long long value[])
+{
+	auto per_edge = [&](long long v) { return v < 0 || n_edge == 0 ? NAN : (double)v / n_edge; };
+	printf("   counters     | cycles %lld | instructions %lld | IPC %.2f | LLC misses %lld, %.4f per edge"
+		   " | dTLB misses %lld, %.4f per edge\n",
+		   value[PerfCounters::CYCLES], value[PerfCounters::INSTRUCTIONS],
+		   value[PerfCounters::CYCLES] > 0 && value[PerfCounters::INSTRUCTIONS] >= 0
+			   ? (double)value[PerfCounters::INSTRUCTIONS] / value[PerfCounters::CYCLES] : NAN,
+		   value[PerfCounters::LLC_MISSES], per_edge(value[PerfCounters::LLC_MISSES]),
+		   value[PerfCounters::DTLB_MISSES], per_edge(value[PerfCounters::DTLB_MISSES]));
+}
+
+/**
+ * @brief What every run shares, whichever view the graph is colored through
+ *
+ * @param input: input graph
+ * @param detect_conflicts: conflict check of the coloring distance on the input graph
+ * @param n_vertex: number of vertices
+ * @param order: sequence to color vertices in, nullptr for natural order
+ * @param perm: relabeling of the colored graph, nullptr if none
+ * @param threads: thread counts of the parallel runs
+ * @param n_warmup: unmeasured runs of every configuration
+ * @param n_run: measured runs of every configuration
+ * @param cpus: cpus to pin threads to, nullptr to leave them to the OS
+ * @param verbose: print the per-phase breakdown of every run
+ * @param counters: print the hardware counters of every run
+ * @param format: table, or one JSON or CSV record per run
+ * @param info: graph statistics and settings the records repeat
+ * @param notes: stream for everything but the results, stderr unless printing the table
+ * @param n_iteration: iterated greedy recolorings after every parallel coloring
+ * @param class_order: class sequence of the iterated greedy recolorings
+ * @param balance: even out the color classes after every parallel coloring
+ * @param coloring_path: file to write the reported coloring of the last configuration and its color classes to, nullptr for none
+ */
+typedef struct session
+{
+	Adjacency::Csr input;
+	int (*detect_conflicts)(const Adjacency::Csr &, vertex_t, int[], int[]);
+	vertex_t n_vertex;
+	int *order;
+	int *perm;
+	std::vector<int> threads;
+	int n_warmup;
+	int n_run;
+	const std::vector<int> *cpus;
+	bool verbose;
+	bool counters;
+	Output::format format;
+	Output::context *info;
+	FILE *notes;
+	int n_iteration;
+	std::string class_order;
+	bool balance;
+	const char *coloring_path;
+} session;
 
-	/**
-	 * @brief Simple First Fit algorithm that always finds the smallest available color for the vertex
-	 *
-	 * @param vid: vertex id
-	 * @param row: row pointer
-	 * @param col: column pointer
-	 * @param n_vertex: number of vertices
-	 * @param colormap: color array shaped (n_vertex, )
-	 * @param color_used: array to track used colors
-	 */
-	int firstfit(int vid, edge_t *row, vertex_t *col, vertex_t n_vertex, int colormap[], bool color_used[])
+/**
+ * @brief Pin every thread of the next parallel regions to its own cpu, round robin over the allowed ones
+ *
+ * @param cpus: cpus the process may run on
+ */
+void pin_threads(const std::vector<int> &cpus)
+{
+	#pragma omp parallel
 	{
-		int row_l = row[vid];
-		int row_r = row[vid + 1];
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+}
 
-		// track whether a color is used it not
-		for (int i = row_l; i < row_r; i++)
-		{
-			int c = colormap[col[i]];
-			if (c >= 0)
-				color_used[c] = true;
+/**
+ * @brief Run the sequential coloring, then the parallel one on every thread count of the session
+ *
+ * Every configuration runs n_warmup times unmeasured, then n_run times measured. The run with
+ * the median time is the one reported, with the summary of all the measured times. Every
+ * coloring is mapped back to the input ids and checked for conflicts on the input graph. The
+ * coloring of the reported run of the last configuration, in input ids, is written out if the
+ * session asks for it, which keeps a copy of every measured coloring of that configuration.
+ *
+ * @param coloring: engine to run
+ * @param g: graph to color, relabeled by perm if there is one
+ * @param s: shared settings
+ */
+template <typename G>
+void run(engine<G> coloring, const G &g, const session &s)
+{
+	vertex_t n_vertex = s.n_vertex;
+	int *order = s.order, *perm = s.perm;
+	int *colormap = new int[n_vertex];
+	int *g_colormap = perm ? new int[n_vertex] : colormap;
 
-			for (int j = row[col[i]]; j < row[col[i] + 1]; j++)
-			{
-				c = colormap[col[j]];
-				if (c >= 0 && col[j] != vid)
-					color_used[c] = true;
-			}
-		}
+	// used in the detect_conflicts on the input graph, for correctness we only need to check conflict count.
+	int *conflict_vid = new int[n_vertex]();
 
-		// return the smallest unused color
-		for (int c = 0; c < n_vertex + 1; c++)
+	PerfCounters perf;
+	std::vector<std::array<long long, PerfCounters::N_EVENT>> value(s.n_run);
+	bool counting = s.counters;
+	// opened once per configuration, outside the measured window, the runs only enable and disable them
+	auto open_counters = [&]()
+	{
+		// bring up the thread pool first, counters are opened on the threads that exist
+		#pragma omp parallel
 		{
-			if (color_used[c])
-				continue;
+		}
+		if (counting && !perf.open())
+		{
+			fprintf(s.notes, " Hardware counters unavailable, %s\n", perf.error().c_str());
+			counting = false;
+		}
+	};
 
-			for (int i = row_l; i < row_r; i++)
+	// median coloring of the configuration to write, and which one it is
+	std::vector<int> written;
+	std::string written_method;
+	int written_threads = 0;
+
+	// warm up, then measure one configuration and print the median run, keeping its coloring if asked
+	auto measure = [&](const char *method, int n_thread, bool parallel, bool keep)
+	{
+		omp_set_num_threads(n_thread);
+		if (s.cpus)
+			pin_threads(*s.cpus);
+		open_counters();
+
+		std::vector<report> runs(s.n_run);
+		std::vector<double> times(s.n_run);
+		std::vector<int> first_pass(s.n_run);
+		std::vector<long long> kernel_edges(s.n_run);
+		std::vector<std::vector<int>> kept(keep ? s.n_run : 0);
+		int conflicts = 0;
+		for (int i = -s.n_warmup; i < s.n_run; i++)
+		{
+			std::fill_n(g_colormap, n_vertex, -1); // reinitialize
+			omp_set_num_threads(n_thread);
+
+			bool counted = counting && i >= 0;
+			if (counted)
+				perf.start();
+			report r = parallel ? coloring.color_graph_par(g, n_vertex, g_colormap, order)
+								: coloring.color_graph_seq(g, n_vertex, g_colormap, order);
+			// the counters cover the coloring kernel alone, as the first pass columns do
+			if (counted)
+				perf.stop(value[i].data());
+			if (i >= 0)
+			{
+				first_pass[i] = r.n_color;
+				for (const phase &p : r.phases)
+					kernel_edges[i] += p.n_edge;
+			}
+			if (parallel && s.n_iteration > 0)
+			{
+				report b = coloring.improve(g, n_vertex, g_colormap, r.n_color, s.n_iteration, s.class_order);
+				r.t_exec += b.t_exec;
+				r.phases.insert(r.phases.end(), b.phases.begin(), b.phases.end());
+				r.n_color = b.n_color;
+			}
+			if (parallel && s.balance)
 			{
-				int c = colormap[col[i]];
-				if (c >= 0)
-					color_used[c] = false;
-
-				for (edge_t j = row[col[i]]; j < row[col[i] + 1]; j++)
-				{
-					c = colormap[col[j]];
-					if (c >= 0 && col[j] != vid)
-						color_used[c] = false;
-				}
+				report b = coloring.balance(g, n_vertex, g_colormap, r.n_color, BALANCE_ROUNDS);
+				r.t_exec += b.t_exec;
+				r.phases.insert(r.phases.end(), b.phases.begin(), b.phases.end());
+				r.class_imbalance = b.class_imbalance;
+				r.n_moved = b.n_moved;
 			}
-			return c;
+			if (i < 0)
+				continue;
+			if (perm)
+				Reorder::unpermute(n_vertex, perm, g_colormap, colormap);
+
+			omp_set_num_threads(1);
+			conflicts = std::max(conflicts, s.detect_conflicts(s.input, n_vertex, colormap, conflict_vid));
+			if (std::isnan(r.class_imbalance))
+				r.class_imbalance = class_imbalance(n_vertex, colormap, r.n_color);
+			if (keep)
+				kept[i].assign(colormap, colormap + n_vertex);
+			times[i] = r.t_exec;
+			runs[i] = std::move(r);
 		}
 
-		throw std::runtime_error("exhaust color limit |v|+1");
-	}
-
-	/**
-	 * @brief Color the graph sequentially
-	 *
-	 * @param row: row pointer
-	 * @param col: column pointer
-	 * @param n_vertex: number of vertices
-	 * @param colormap: color array shaped (n_vertex, )
-	 */
-	report color_graph_seq(edge_t *row, vertex_t *col, vertex_t n_vertex, int colormap[])
-	{
-		report result;
-		double t_start, t_end;
-		int n_color = 0;
-		bool *color_used = new bool[n_vertex + 1]();
+		std::vector<int> rank(s.n_run);
+		for (int i = 0; i < s.n_run; i++)
+			rank[i] = i;
+		std::sort(rank.begin(), rank.end(), [&](int a, int b) { return times[a] < times[b]; });
+		int median = rank[(s.n_run - 1) / 2];
+		timing t = timing::of(times);
+		report r = runs[median];
+		r.t_exec = t.t_median;
+		if (keep)
+		{
+			written.swap(kept[median]);
+			written_method = method;
+			written_threads = n_thread;
+		}
 
-		t_start = omp_get_wtime();
-		for (int i = 0; i < n_vertex; i++)
+		if (s.format != Output::TABLE)
 		{
-			int c = firstfit(i, row, col, n_vertex, colormap, color_used);
-			colormap[i] = c;
-			if (c > n_color)
-				n_color = c;
+			Output::print_record(stdout, s.format, *s.info, method, n_thread, r, t, conflicts,
+								 counting ? value[median].data() : nullptr);
+			return;
 		}
-		t_end = omp_get_wtime();
-		delete[] color_used;
+		print_report(n_thread, r, method, conflicts);
+		if (s.n_run > 1)
+			print_timing(t);
+		if (parallel && s.n_iteration > 0)
+			print_iterated(r, first_pass[median], s.n_iteration);
+		if (s.verbose || r.n_moved >= 0)
+			print_classes(r);
+		if (s.verbose)
+			print_phases(r);
+		if (counting)
+			print_counters(kernel_edges[median], value[median].data());
+	};
+
+	if (s.format == Output::TABLE)
+		print_header();
+	else if (s.format == Output::CSV)
+		Output::print_csv_header(stdout);
 
-		result.n_color = n_color + 1;
-		result.t_exec = t_end - t_start;
-		result.n_conflict = 0;
+	// Sequential versions
+	measure("Sequential", 1, false, s.coloring_path && s.threads.empty());
+
+	// Parallel versions
+	for (size_t k = 0; k < s.threads.size(); k++)
+		measure("Parallel", s.threads[k], true, s.coloring_path && k + 1 == s.threads.size());
 
-		return result;
+	if (s.coloring_path)
+	{
+		omp_set_num_threads(written_threads);
+		double t_write = omp_get_wtime();
+		if (write_coloring(s.coloring_path, written.data(), n_vertex) != 0)
+			fprintf(s.notes, " Could not write the coloring to %s\n", s.coloring_path);
+		else
+			fprintf(s.notes, " Coloring of %s on %d threads, run of median time, and its color classes written to %s in %.10f s\n",
+					written_method.c_str(), written_threads, s.coloring_path, omp_get_wtime() - t_write);
 	}
 
-	report color_graph_par(edge_t *row, vertex_t *col, vertex_t n_vertex, int colormap[])
+	delete[] conflict_vid;
+	if (perm)
+		delete[] g_colormap;
+	delete[] colormap;
+}
+
+/**
+ * @brief Run on g, or on its square graph for distance-2 coloring when given a budget
+ *
+ * @param g: graph to color, relabeled by perm if there is one
+ * @param distance: coloring distance
+ * @param algorithm: spec or jp
+ * @param square_mb: memory budget of the square graph in MB, negative to walk g at distance 2
+ * @param s: shared settings
+ */
+template <typename G>
+void run_on(const G &g, int distance, const std::string &algorithm, long long square_mb, const session &s)
+{
+	if (distance == 1 || square_mb < 0)
 	{
-		report result;
-		double t_start, t_end;
-		int n_merge_conflict = -1;
+		run(select_engine<G>(distance, algorithm), g, s);
+		return;
+	}
 
-		int *conflicts = new int[n_vertex / 2 + 1]();
-		bool *heatmap = new bool[n_vertex]();
-		static bool *color_used;
-		#pragma omp threadprivate(color_used)
+	double t_square = omp_get_wtime();
+	Adjacency::Square<G> square(g, s.n_vertex, (uint64_t)square_mb << 20);
+	t_square = omp_get_wtime() - t_square;
+	s.info->t_square = t_square;
+	fprintf(s.notes, " Square graph built in %.10f s, %d of %d blocks stored in %.1f MB\n", t_square,
+		   square.stored_blocks(), (s.n_vertex + square.BLOCK - 1) / square.BLOCK, square.bytes() / 1048576.0);
+	run(select_engine<Adjacency::Square<G>>(1, algorithm), square, s);
+}
 
-		#pragma omp parallel
-		{
-			color_used = new bool[n_vertex + 1]();
-		}
+void print_usage()
+{
+	std::cout << "Usage: ./coloring [-d DISTANCE] [-a ALGORITHM] [-o ORDERING] [-r REORDER] [-z] [-S MB] [-P] [-v] [-H] [-f FORMAT] [-t LIST] [-w N] [-n N] [-b] [-I N] [-C ORDER] [-B] [-c PATH] [FILE] [THREADS]" << std::endl
+			  << "  -d DISTANCE   coloring distance, 1 or 2 (default: 2)" << std::endl
+			  << "  -a ALGORITHM  spec: speculative first fit with conflict rounds (default)" << std::endl
+			  << "                jp:   Jones-Plassmann, same coloring for any number of threads" << std::endl
+			  << "  -o ORDERING   sequence to color vertices in, natural (default), lf (largest first)," << std::endl
+			  << "                sl (smallest last), id (incidence degree) or random" << std::endl
+			  << "  -r REORDER    relabel the graph for locality before coloring, none (default)," << std::endl
+			  << "                rcm (reverse Cuthill-McKee), bfs or degree" << std::endl
+			  << "  -z            color on a delta and varint compressed copy of the adjacency" << std::endl
+			  << "  -S MB         distance 2: precompute the square graph in at most MB megabytes and" << std::endl
+			  << "                color it at distance 1, blocks that do not fit are walked on the fly" << std::endl
+			  << "  -P            prefault the mapped binary cache instead of paging it in lazily" << std::endl
+			  << "  -v            print the time, vertices, edges and thread balance of every phase of a run" << std::endl
+			  << "  -H            print cycles, instructions, LLC and dTLB misses of every run (perf_event_open)" << std::endl
+			  << "  -f FORMAT     table (default), json (one object per line) or csv, one record per run" << std::endl
+			  << "  -t LIST       comma separated thread counts of the parallel runs, instead of 1, 2, 4, ... THREADS" << std::endl
+			  << "  -w N          unmeasured warm-up runs before every configuration (default: 0)" << std::endl
+			  << "  -n N          measured runs of every configuration, the median one is reported (default: 1)" << std::endl
+			  << "  -b            pin every thread to its own cpu" << std::endl
+			  << "  -I N          recolor by first fit in color class order N times after every parallel coloring" << std::endl
+			  << "  -C ORDER      class order of -I, reverse, largest, random or mixed (default), which cycles" << std::endl
+			  << "  -B            even out the color class sizes after every parallel coloring, same number of colors" << std::endl
+			  << "  -c PATH       write the coloring of the median run of the last configuration and its color classes to PATH" << std::endl;
+}
 
-		t_start = omp_get_wtime();
-		#pragma omp parallel for
-		for (int i = 0; i < n_vertex; i++)
-		{
-			int c = firstfit(i, row, col, n_vertex, colormap, color_used);
-			colormap[i] = c;
-		}
+int main(int argc, char *argv[])
+{
+	using namespace std;
 
-		int n_conflict = 0;
-		do
+	int distance = 2;
+	string algorithm = "spec";
+	string ordering = "natural";
+	string reorder = "none";
+	// coloring only needs the structure, weights are never loaded
+	int read_flags = GRAPH_WILLNEED | GRAPH_STRUCTURE;
+	bool compress = false;
+	long long square_mb = -1;
+	bool verbose = false;
+	bool counters = false;
+	Output::format format = Output::TABLE;
+	vector<int> thread_list;
+	int n_warmup = 0;
+	int n_run = 1;
+	bool bind = false;
+	const char *coloring_path = nullptr;
+	bool balance = false;
+	int n_iteration = 0;
+	string class_order = "mixed";
+	int opt;
+	while ((opt = getopt(argc, argv, "d:a:o:r:zS:PvHf:t:w:n:bc:BI:C:")) != -1)
+	{
+		switch (opt)
 		{
-			// detect conflicted vertices and recolor
-			n_conflict = detect_conflicts(row, col, n_vertex, colormap, heatmap, conflicts);
-			#pragma omp for
-			for (int i = 0; i < n_conflict; i++)
+		case 'd':
+			distance = stoi(optarg);
+			break;
+		case 'a':
+			algorithm = optarg;
+			break;
+		case 'o':
+			ordering = optarg;
+			break;
+		case 'r':
+			reorder = optarg;
+			break;
+		case 'z':
+			compress = true;
+			break;
+		case 'S':
+			square_mb = stoll(optarg);
+			break;
+		case 'P':
+			read_flags |= GRAPH_POPULATE;
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		case 'H':
+			counters = true;
+			break;
+		case 'f':
+			if (!Output::parse(optarg, &format))
 			{
-				int c = firstfit(conflicts[i], row, col, n_vertex, colormap, color_used);
-				colormap[conflicts[i]] = c;
+				print_usage();
+				exit(EXIT_FAILURE);
 			}
-			++n_merge_conflict;
-		} while (n_conflict > 0);
-		t_end = omp_get_wtime();
-
-		// clean up
-		delete[] heatmap;
-		delete[] conflicts;
-		#pragma omp parallel
-		{
-			delete[] color_used;
+			break;
+		case 't':
+			for (char *tok = strtok(optarg, ","); tok; tok = strtok(nullptr, ","))
+				thread_list.push_back(atoi(tok));
+			break;
+		case 'w':
+			n_warmup = stoi(optarg);
+			break;
+		case 'n':
+			n_run = stoi(optarg);
+			break;
+		case 'b':
+			bind = true;
+			break;
+		case 'c':
+			coloring_path = optarg;
+			break;
+		case 'B':
+			balance = true;
+			break;
+		case 'I':
+			n_iteration = stoi(optarg);
+			break;
+		case 'C':
+			class_order = optarg;
+			break;
+		default:
+			print_usage();
+			exit(EXIT_FAILURE);
 		}
-		result.n_color = max(n_vertex, colormap);
-		result.t_exec = t_end - t_start;
-		result.n_conflict = n_merge_conflict;
-		return result;
 	}
-}
-
-int main(int argc, char *argv[])
-{
-	using namespace std;
 
 	// program called with ./coloring
-	// should be ./coloring [FILE] [MAX_THREADS]
-	if (argc < 2)
+	// should be ./coloring [OPTIONS] [FILE] [MAX_THREADS]
+	const string orderings[] = {"natural", "lf", "sl", "id", "random"};
+	const string reorders[] = {"none", "rcm", "bfs", "degree"};
+	if (argc - optind < 1 || (distance != 1 && distance != 2) || (algorithm != "spec" && algorithm != "jp") ||
+		find(begin(orderings), end(orderings), ordering) == end(orderings) ||
+		find(begin(reorders), end(reorders), reorder) == end(reorders) || n_warmup < 0 || n_run < 1 ||
+		n_iteration < 0 || !IteratedGreedy::is_class_order(class_order) ||
+		any_of(thread_list.begin(), thread_list.end(), [](int t) { return t < 1; }))
 	{
-		cout << "Usage: ./coloring [FILE] [THREADS]" << endl;
+		print_usage();
 		exit(EXIT_FAILURE);
 	}
 
 	int max_threads = 16;
-	if (argc == 3)
+	if (argc - optind == 2)
+	{
+		max_threads = min(stoi(argv[optind + 1]), omp_get_max_threads());
+	}
+	if (thread_list.empty())
+		for (int threads = 1; threads <= max_threads; threads <<= 1)
+			thread_list.push_back(threads);
+
+	// cpus the process may run on, threads are pinned round robin over them
+	vector<int> cpus;
+	if (bind)
 	{
-		max_threads = min(stoi(argv[2]), omp_get_max_threads());
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		sched_getaffinity(0, sizeof(allowed), &allowed);
+		for (int c = 0; c < CPU_SETSIZE; c++)
+			if (CPU_ISSET(c, &allowed))
+				cpus.push_back(c);
 	}
 
+	int (*detect_conflicts)(const Adjacency::Csr &, vertex_t, int[], int[]);
+	if (distance == 1)
+		detect_conflicts = D1Coloring::detect_conflicts<Adjacency::Csr>;
+	else
+		detect_conflicts = D2Coloring::detect_conflicts<Adjacency::Csr>;
+
 	edge_t *row_ptr;
 	vertex_t *col_ind;
 	eweight_t *ewghts;
 	vweight_t *vwghts;
 	vertex_t n_vertex;
 
-	if (read_graph(argv[1], &row_ptr, &col_ind, &ewghts, &vwghts, &n_vertex, 0) == -1)
+	if (read_graph(argv[optind], &row_ptr, &col_ind, &ewghts, &vwghts, &n_vertex, 0, read_flags) == -1)
 	{
 		cout << "error in graph read" << endl;
 		exit(EXIT_FAILURE);
 	}
 
-	// Performance analysis
-	report r;
-
-	int *colormap = new int[n_vertex];
-	fill_n(colormap, n_vertex, -1);
-
-	print_header();
-
-	// Sequential versions
-	r = D2Coloring::color_graph_seq(row_ptr, col_ind, n_vertex, colormap);
-
-	int conflicts;
-
-	// these two are used in the detect_conflicts, for correctness we only need to check conflict count.
-	bool *heatmap = new bool[n_vertex]();
-	int *conflict_vid = new int[n_vertex]();
-
-	omp_set_num_threads(1);
-	conflicts = D2Coloring::detect_conflicts(row_ptr, col_ind, n_vertex, colormap, heatmap, conflict_vid);
-	fill_n(heatmap, n_vertex, false);
-
-	print_report(1, r, "Sequential", conflicts);
-
-	// Parallel versions
-	int threads = 1;
-	while (threads <= max_threads)
+	// results go to stdout, the rest to stderr so records can be piped as they are
+	FILE *notes = format == Output::TABLE ? stdout : stderr;
+	edge_t max_degree = 0;
+	for (vertex_t v = 0; v < n_vertex; v++)
+		max_degree = max(max_degree, row_ptr[v + 1] - row_ptr[v]);
+	Output::context info = {argv[optind], n_vertex, row_ptr[n_vertex], max_degree, distance, algorithm, ordering,
+							reorder, compress, square_mb, n_warmup, bind, n_iteration, class_order, balance,
+							NAN, NAN, NAN, NAN};
+
+	// graph the colorings run on, relabeled if asked to
+	edge_t *g_row = row_ptr;
+	vertex_t *g_col = col_ind;
+	int *perm = nullptr;
+	if (reorder != "none")
 	{
-		fill_n(colormap, n_vertex, -1); // reinitialize
-		omp_set_num_threads(threads);
-
-		r = D2Coloring::color_graph_par(row_ptr, col_ind, n_vertex, colormap);
-
-		omp_set_num_threads(1);
-		conflicts = D2Coloring::detect_conflicts(row_ptr, col_ind, n_vertex, colormap, heatmap, conflict_vid);
-		fill_n(heatmap, n_vertex, false);
+		perm = new int[n_vertex];
+		double t_reorder = omp_get_wtime();
+		if (!Reorder::compute(reorder, row_ptr, col_ind, n_vertex, perm))
+		{
+			print_usage();
+			exit(EXIT_FAILURE);
+		}
+		Reorder::permute(row_ptr, col_ind, n_vertex, perm, &g_row, &g_col);
+		t_reorder = omp_get_wtime() - t_reorder;
+		info.t_reorder = t_reorder;
+		fprintf(notes, " Reordering %s computed in %.10f s\n", reorder.c_str(), t_reorder);
+	}
 
-		print_report(threads, r, "Parallel", conflicts);
+	// vertex ordering, computed once and shared by every run
+	int *order = nullptr;
+	if (ordering != "natural")
+	{
+		order = new int[n_vertex];
+		double t_order = omp_get_wtime();
+		if (!Ordering::compute(ordering, g_row, g_col, n_vertex, order))
+		{
+			print_usage();
+			exit(EXIT_FAILURE);
+		}
+		t_order = omp_get_wtime() - t_order;
+		info.t_order = t_order;
+		fprintf(notes, " Ordering %s computed in %.10f s\n", ordering.c_str(), t_order);
+	}
 
-		threads <<= 1;
+	session s = {{row_ptr, col_ind}, detect_conflicts, n_vertex, order, perm, thread_list, n_warmup, n_run,
+				 bind ? &cpus : nullptr, verbose, counters, format, &info, notes, n_iteration, class_order, balance,
+				 coloring_path};
+	if (compress)
+	{
+		double t_compress = omp_get_wtime();
+		Adjacency::Compressed z(g_row, g_col, n_vertex);
+		t_compress = omp_get_wtime() - t_compress;
+		info.t_compress = t_compress;
+		fprintf(notes, " Compressed adjacency in %.10f s, %.2f bytes per edge\n", t_compress,
+			   (double)z.bytes() / std::max<edge_t>(g_row[n_vertex], 1));
+		run_on(z, distance, algorithm, square_mb, s);
+	}
+	else
+	{
+		run_on(Adjacency::Csr{g_row, g_col}, distance, algorithm, square_mb, s);
 	}
 
+	if (perm)
+	{
+		delete[] g_row;
+		delete[] g_col;
+		delete[] perm;
+	}
+	delete[] order;
+	free_graph(row_ptr, col_ind, ewghts, vwghts);
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,45 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "utils/graph.h"
+#include "report.h"
+#include "greedy.h"
+#include "jones_plassmann.h"
+#include "balance.h"
+#include "iterated.h"
+
+#include <string>
+
+/**
+ * @brief Coloring engine over the adjacency view G, the functions of one of the coloring namespaces
+ * and the post-passes of its distance, class balancing and iterated greedy
+ */
+template <typename G>
+struct engine
+{
+	report (*color_graph_seq)(const G &, vertex_t, int[], int[]);
+	report (*color_graph_par)(const G &, vertex_t, int[], int[]);
+	report (*balance)(const G &, vertex_t, int[], int, int);
+	report (*improve)(const G &, vertex_t, int[], int, int, const std::string &);
+};
+
+/**
+ * @brief Engine of a coloring distance, 1 or 2, and algorithm, spec or jp
+ */
+template <typename G>
+engine<G> select_engine(int distance, const std::string &algorithm)
+{
+	if (algorithm == "jp" && distance == 1)
+		return {JonesPlassmann::color_graph_seq<1, G>, JonesPlassmann::color_graph_par<1, G>, Balance::balance<1, G>,
+				IteratedGreedy::improve<1, G>};
+	if (algorithm == "jp")
+		return {JonesPlassmann::color_graph_seq<2, G>, JonesPlassmann::color_graph_par<2, G>, Balance::balance<2, G>,
+				IteratedGreedy::improve<2, G>};
+	if (distance == 1)
+		return {D1Coloring::color_graph_seq<G>, D1Coloring::color_graph_par<G>, Balance::balance<1, G>,
+				IteratedGreedy::improve<1, G>};
+	return {D2Coloring::color_graph_seq<G>, D2Coloring::color_graph_par<G>, Balance::balance<2, G>,
+				IteratedGreedy::improve<2, G>};
+}
+
+#endif
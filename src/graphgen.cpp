@@ -0,0 +1,54 @@
+#include "utils/graphio.h"
+#include "utils/graph.h"
+#include "utils/gen.h"
+
+#include <iostream>
+#include <omp.h>
+
+void print_usage()
+{
+	std::cout << "Usage: ./graphgen SPEC PATH" << std::endl
+			  << "  Generate a synthetic graph and write it as the binary cache of PATH, so that" << std::endl
+			  << "  ./coloring PATH maps it directly. SPEC is one of" << std::endl
+			  << "    rmat:SCALE:EDGE_FACTOR[:SEED]  R-MAT / Kronecker, Graph500 probabilities" << std::endl
+			  << "    grid2d:NX:NY[:POINTS]          2D stencil, 5 (default) or 9 points" << std::endl
+			  << "    grid3d:NX:NY:NZ[:POINTS]       3D stencil, 7 (default) or 27 points" << std::endl
+			  << "    rgg:N:DEGREE[:SEED]            random geometric graph in the unit square" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3 || !is_gen_spec(argv[1]))
+	{
+		print_usage();
+		exit(EXIT_FAILURE);
+	}
+
+	edge_t *xadj;
+	vertex_t *adj;
+	vertex_t n_vertex;
+
+	double t_gen = omp_get_wtime();
+	if (gen_graph(argv[1], &xadj, &adj, &n_vertex) != 0)
+	{
+		std::cout << "error in graph generation, bad spec or too many edges for the index width" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	t_gen = omp_get_wtime() - t_gen;
+
+	edge_t max_degree = 0;
+	for (vertex_t v = 0; v < n_vertex; v++)
+		max_degree = std::max(max_degree, xadj[v + 1] - xadj[v]);
+	printf(" %s: %d vertices, %llu stored edges, max degree %llu, generated in %.10f s\n", argv[1], n_vertex,
+		   (unsigned long long)xadj[n_vertex], (unsigned long long)max_degree, t_gen);
+
+	// structure only, as a structure-only read of a file would cache it
+	if (write_cache(argv[2], xadj, adj, nullptr, nullptr, n_vertex) != 0)
+	{
+		std::cout << "error in cache write" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	free_graph(xadj, adj, nullptr, nullptr);
+	return 0;
+}
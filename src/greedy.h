@@ -0,0 +1,553 @@
+#ifndef GREEDY_H
+#define GREEDY_H
+
+#include "utils/graph.h"
+#include "utils/colorset.h"
+#include "adjacency.h"
+#include "report.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Greedy first fit coloring kernels, shared by the distance-1 and distance-2 engines
+ *
+ * Every kernel is templated on the coloring distance, the only thing that differs
+ * between the two is which vertices visit_neighbors walks, and on the adjacency
+ * view G it reads the graph through, see adjacency.h.
+ */
+namespace Greedy
+{
+	/**
+	 * @brief Call f on every vertex within the given distance of vid, excluding vid itself
+	 *
+	 * A vertex reachable through several paths is visited once per path.
+	 *
+	 * @param vid: vertex id
+	 * @param g: adjacency view
+	 * @param f: visitor, returns true to stop the walk
+	 * @return whether the walk was stopped by f
+	 */
+	template <int distance, typename G, typename F>
+	inline bool visit_neighbors(int vid, const G &g, F f)
+	{
+		static_assert(distance == 1 || distance == 2, "only distance-1 and distance-2 coloring are supported");
+
+		return g.visit(vid, [&](int u)
+		{
+			if (f(u))
+				return true;
+
+			if constexpr (distance == 2)
+				return g.visit(u, [&](int w) { return w != vid && f(w); });
+			return false;
+		});
+	}
+
+	/**
+	 * @brief Concatenate thread-local buffers in thread order, must be called by every thread of an enclosing parallel region
+	 *
+	 * An exclusive prefix sum over the buffer sizes gives each thread its output offset.
+	 *
+	 * @param local: thread-local buffer
+	 * @param offset: shared array shaped (n_thread + 1, )
+	 * @param out: output array
+	 * @return total length, the same in every thread
+	 */
+	inline unsigned int concat_ws(std::vector<int> &local, unsigned int offset[], int out[])
+	{
+		int tid = omp_get_thread_num();
+		int n_thread = omp_get_num_threads();
+
+		offset[tid + 1] = local.size();
+		#pragma omp barrier
+
+		#pragma omp single
+		{
+			offset[0] = 0;
+			for (int t = 0; t < n_thread; t++)
+				offset[t + 1] += offset[t];
+		}
+
+		std::copy(local.begin(), local.end(), out + offset[tid]);
+		unsigned int count = offset[n_thread];
+		#pragma omp barrier
+
+		return count;
+	}
+
+	/**
+	 * @brief Whether vid has to be recolored to resolve a conflict
+	 *
+	 * Of two conflicting vertices recolored in the same round the smaller id gives way. A neighbor recolored
+	 * in an earlier round was visible to vid in firstfit, so vid always gives way to it.
+	 *
+	 * @param vid: vertex id
+	 * @param g: adjacency view
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param recolored: round in which each vertex was last colored, nullptr if all in the current round
+	 * @param round: current round
+	 * @param n_edge: incremented by the number of edges traversed
+	 */
+	template <int distance, typename G>
+	inline bool is_conflicted(int vid, const G &g, int colormap[], int recolored[], int round, long long &n_edge)
+	{
+		int c = colormap[vid];
+		return visit_neighbors<distance>(vid, g, [&](int u)
+		{
+			n_edge++;
+			return colormap[u] == c && (vid < u || (recolored && recolored[u] != round));
+		});
+	}
+
+	template <int distance, typename G>
+	inline bool is_conflicted(int vid, const G &g, int colormap[], int recolored[], int round)
+	{
+		long long n_edge = 0;
+		return is_conflicted<distance>(vid, g, colormap, recolored, round, n_edge);
+	}
+
+	/**
+	 * @brief Work-sharing conflict detection, must be called by every thread of an enclosing parallel region
+	 *
+	 * Only the vertices colored in the last round can be in conflict, so only their neighborhoods
+	 * are inspected. Every conflicted vertex is reported once, by itself. Threads collect into
+	 * local buffers that are concatenated in thread order, so the output follows the worklist order.
+	 *
+	 * @param g: adjacency view
+	 * @param worklist: vertices colored in the last round, nullptr for all vertices
+	 * @param n_work: length of worklist, or number of vertices
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param recolored: round in which each vertex was last colored, nullptr if all in the current round
+	 * @param round: current round
+	 * @param local: thread-local buffer
+	 * @param offset: shared array shaped (n_thread + 1, )
+	 * @param conflict_vid: output array to store conflicted vertices, at least n_work long
+	 * @param profile: records a detect phase when given
+	 * @return number of conflicted vertices, the same in every thread
+	 */
+	template <int distance, typename G>
+	unsigned int detect_conflicts_ws(const G &g, int worklist[], int n_work, int colormap[],
+									 int recolored[], int round, std::vector<int> &local,
+									 unsigned int offset[], int conflict_vid[], Profile *profile = nullptr)
+	{
+		double t_start = omp_get_wtime();
+		long long n_edge = 0;
+
+		local.clear();
+		#pragma omp for schedule(static) nowait
+		for (int w = 0; w < n_work; w++)
+		{
+			int vid = worklist ? worklist[w] : w;
+			if (is_conflicted<distance>(vid, g, colormap, recolored, round, n_edge))
+				local.push_back(vid);
+		}
+		if (profile)
+			profile->record("detect", round, n_work, t_start, n_edge);
+
+		return concat_ws(local, offset, conflict_vid);
+	}
+
+	/**
+	 * @brief Find number of conflicts in the graph
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param conflict_vid: output array to store conflicted vertices
+	*/
+	template <int distance, typename G>
+	int detect_conflicts(const G &g, vertex_t n_vertex, int colormap[], int conflict_vid[])
+	{
+		unsigned int count = 0;
+		unsigned int *offset = new unsigned int[omp_get_max_threads() + 1]();
+
+		#pragma omp parallel
+		{
+			std::vector<int> local;
+			unsigned int n = detect_conflicts_ws<distance>(g, nullptr, n_vertex, colormap, nullptr, 0,
+														   local, offset, conflict_vid);
+			#pragma omp master
+			count = n;
+		}
+
+		delete[] offset;
+		return count;
+	}
+
+	/**
+	 * @brief Number of vertices visit_neighbors walks from vid, an upper bound of its colored neighbors
+	 *
+	 * @param vid: vertex id
+	 * @param g: adjacency view
+	 */
+	template <int distance, typename G>
+	inline long long degree(int vid, const G &g)
+	{
+		long long deg = g.degree(vid);
+		if constexpr (distance == 2)
+		{
+			g.visit(vid, [&](int u)
+			{
+				deg += g.degree(u);
+				return false;
+			});
+		}
+		return deg;
+	}
+
+	/**
+	 * @brief Upper bound of the number of colored neighbors within the given distance of any vertex
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 */
+	template <int distance, typename G>
+	int max_degree(const G &g, vertex_t n_vertex)
+	{
+		long long val = 0;
+		#pragma omp parallel for reduction(max : val)
+		for (int i = 0; i < n_vertex; i++)
+		{
+			long long deg = degree<distance>(i, g);
+			if (deg > val)
+				val = deg;
+		}
+		return (int)std::min(val, (long long)n_vertex);
+	}
+
+	/**
+	 * @brief Simple First Fit algorithm that always finds the smallest available color for the vertex
+	 *
+	 * @param vid: vertex id
+	 * @param g: adjacency view
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param forbidden: scratch set sized max_degree + 1
+	 * @param n_edge: incremented by the number of edges traversed
+	 */
+	template <int distance, typename G>
+	int firstfit(int vid, const G &g, int colormap[], ColorSet &forbidden, long long &n_edge)
+	{
+		// track whether a color is used it not
+		forbidden.clear();
+		visit_neighbors<distance>(vid, g, [&](int u)
+		{
+			n_edge++;
+			int c = colormap[u];
+			if (c >= 0)
+				forbidden.insert(c);
+			return false;
+		});
+
+		// return the smallest unused color
+		int c = forbidden.first_free();
+		if (c < 0)
+			throw std::runtime_error("exhaust color limit max_degree+1");
+		return c;
+	}
+
+	template <int distance, typename G>
+	int firstfit(int vid, const G &g, int colormap[], ColorSet &forbidden)
+	{
+		long long n_edge = 0;
+		return firstfit<distance>(vid, g, colormap, forbidden, n_edge);
+	}
+
+	/**
+	 * @brief Color the graph sequentially
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param order: sequence to color vertices in, nullptr for natural order
+	 */
+	template <int distance, typename G>
+	report color_graph_seq(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		report result;
+		double t_start, t_end;
+		int n_color = 0;
+		long long n_edge = 0;
+		ColorSet forbidden(max_degree<distance>(g, n_vertex) + 1);
+		Profile profile(1);
+
+		t_start = omp_get_wtime();
+		for (int i = 0; i < n_vertex; i++)
+		{
+			int vid = order ? order[i] : i;
+			int c = firstfit<distance>(vid, g, colormap, forbidden, n_edge);
+			colormap[vid] = c;
+			if (c > n_color)
+				n_color = c;
+		}
+		profile.record("color", 0, n_vertex, t_start, n_edge);
+		t_end = omp_get_wtime();
+
+		result.n_color = n_color + 1;
+		result.t_exec = t_end - t_start;
+		result.n_conflict = 0;
+		result.phases = profile.phases();
+
+		return result;
+	}
+
+	/**
+	 * @brief Color the graph speculatively in parallel, then detect and recolor conflicts until none is left
+	 *
+	 * All rounds run inside one parallel region, each phase is work-shared and separated by barriers.
+	 * Every thread times its share of each phase, see Profile.
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: color array shaped (n_vertex, )
+	 * @param order: sequence to speculatively color vertices in, nullptr for natural order
+	 */
+	template <int distance, typename G>
+	report color_graph_par(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		report result;
+		double t_start, t_end;
+		int round = 0;
+		unsigned int n_work = n_vertex;
+
+		// vertices colored in the current round, and those found conflicted among them
+		int *work = new int[n_vertex]();
+		int *conflicts = new int[n_vertex]();
+		unsigned int *offset = new unsigned int[omp_get_max_threads() + 1]();
+		int *recolored = new int[n_vertex]();
+		int n_forbidden = max_degree<distance>(g, n_vertex) + 1;
+		Profile profile(omp_get_max_threads());
+
+		t_start = omp_get_wtime();
+		#pragma omp parallel
+		{
+			// per-thread scratch for firstfit and conflict detection
+			ColorSet forbidden(n_forbidden);
+			std::vector<int> local;
+			double t_phase = omp_get_wtime();
+			long long n_edge = 0;
+
+			#pragma omp for nowait
+			for (int i = 0; i < n_vertex; i++)
+			{
+				int vid = order ? order[i] : i;
+				int c = firstfit<distance>(vid, g, colormap, forbidden, n_edge);
+				colormap[vid] = c;
+			}
+			profile.record("color", 0, n_vertex, t_phase, n_edge);
+			#pragma omp barrier
+
+			while (true)
+			{
+				// detect conflicts among the vertices colored last round
+				unsigned int n_conflict = detect_conflicts_ws<distance>(g, round == 0 ? nullptr : work, n_work, colormap,
+																		recolored, round, local, offset, conflicts, &profile);
+				if (n_conflict == 0)
+					break;
+
+				t_phase = omp_get_wtime();
+				n_edge = 0;
+				#pragma omp for nowait
+				for (unsigned int i = 0; i < n_conflict; i++)
+				{
+					int c = firstfit<distance>(conflicts[i], g, colormap, forbidden, n_edge);
+					colormap[conflicts[i]] = c;
+					recolored[conflicts[i]] = round + 1;
+				}
+				profile.record("recolor", round + 1, n_conflict, t_phase, n_edge);
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					std::swap(work, conflicts);
+					n_work = n_conflict;
+					++round;
+				}
+			}
+		}
+		t_end = omp_get_wtime();
+
+		// clean up
+		delete[] offset;
+		delete[] recolored;
+		delete[] conflicts;
+		delete[] work;
+		result.n_color = max(n_vertex, colormap);
+		result.t_exec = t_end - t_start;
+		result.n_conflict = round;
+		result.phases = profile.phases();
+		return result;
+	}
+
+	/**
+	 * @brief Repair a coloring after edges were inserted into the graph or vertices added to it
+	 *
+	 * Removing an edge never breaks a coloring, and every pair of vertices an inserted edge (u, v) brings
+	 * within the coloring distance contains u or v, so only the touched vertices can be in conflict.
+	 * Those in conflict and those uncolored are recolored by firstfit, then conflicts among the recolored
+	 * ones are detected and recolored as in color_graph_par until none is left. A touched vertex gives
+	 * way to an untouched one, so the rest of the graph keeps its colors and is never read beyond the
+	 * neighborhoods of the touched vertices. Whether a neighbor was recolored in the same round is
+	 * looked up in the sorted worklist rather than in an array over all vertices.
+	 *
+	 * @param g: adjacency view of the graph after the change
+	 * @param n_vertex: number of vertices after the change
+	 * @param colormap: coloring before the change, -1 for added vertices, repaired in place
+	 * @param touched: endpoints of the inserted edges and the added vertices, in any order, duplicates allowed
+	 * @param n_touched: length of touched
+	 * @param n_color: number of colors before the change
+	 * @return n_color is at least the number of colors in use, n_conflict is the number of recoloring rounds
+	 *         as in color_graph_par, n_recolored is the number of vertices recolored
+	 */
+	template <int distance, typename G>
+	report repair(const G &g, vertex_t n_vertex, int colormap[], const int touched[], int n_touched, int n_color)
+	{
+		report result;
+		double t_start, t_end;
+		int round = 0;
+		int n_recolored = 0;
+
+		t_start = omp_get_wtime();
+		std::vector<int> work(touched, touched + n_touched);
+		std::sort(work.begin(), work.end());
+		work.erase(std::unique(work.begin(), work.end()), work.end());
+		std::vector<int> conflicts(work.size());
+		unsigned int n_work = work.size();
+		int *worklist = work.data(), *conflict_vid = conflicts.data();
+
+		// the neighborhoods walked are those of the touched vertices, later rounds only recolor some of them
+		long long n_forbidden = 0;
+		#pragma omp parallel for reduction(max : n_forbidden)
+		for (unsigned int i = 0; i < n_work; i++)
+			n_forbidden = std::max(n_forbidden, degree<distance>(worklist[i], g));
+		n_forbidden = std::min(n_forbidden, (long long)n_vertex) + 1;
+
+		unsigned int *offset = new unsigned int[omp_get_max_threads() + 1]();
+		Profile profile(omp_get_max_threads());
+
+		#pragma omp parallel reduction(max : n_color)
+		{
+			ColorSet forbidden((int)n_forbidden);
+			std::vector<int> local;
+
+			while (true)
+			{
+				// a vertex recolored this round gives way to the larger ids recolored with it and to all others
+				double t_phase = omp_get_wtime();
+				long long n_edge = 0;
+				local.clear();
+				#pragma omp for schedule(static) nowait
+				for (unsigned int i = 0; i < n_work; i++)
+				{
+					int vid = worklist[i];
+					int c = colormap[vid];
+					if (c < 0 || visit_neighbors<distance>(vid, g, [&](int u)
+					{
+						n_edge++;
+						return colormap[u] == c && (vid < u || !std::binary_search(worklist, worklist + n_work, u));
+					}))
+						local.push_back(vid);
+				}
+				profile.record("detect", round, n_work, t_phase, n_edge);
+
+				// concatenated in worklist order, so the next worklist is sorted as well
+				unsigned int n_conflict = concat_ws(local, offset, conflict_vid);
+				if (n_conflict == 0)
+					break;
+
+				t_phase = omp_get_wtime();
+				n_edge = 0;
+				#pragma omp for nowait
+				for (unsigned int i = 0; i < n_conflict; i++)
+				{
+					int c = firstfit<distance>(conflict_vid[i], g, colormap, forbidden, n_edge);
+					colormap[conflict_vid[i]] = c;
+					n_color = std::max(n_color, c + 1);
+				}
+				profile.record("recolor", round + 1, n_conflict, t_phase, n_edge);
+				#pragma omp barrier
+
+				#pragma omp single
+				{
+					std::swap(worklist, conflict_vid);
+					n_work = n_conflict;
+					n_recolored += n_conflict;
+					++round;
+				}
+			}
+		}
+		t_end = omp_get_wtime();
+
+		delete[] offset;
+		result.n_color = n_color;
+		result.t_exec = t_end - t_start;
+		result.n_conflict = round;
+		result.n_recolored = n_recolored;
+		result.phases = profile.phases();
+		return result;
+	}
+}
+
+/**
+ * @brief Distance-1 coloring, adjacent vertices get different colors
+ */
+namespace D1Coloring
+{
+	template <typename G>
+	inline int detect_conflicts(const G &g, vertex_t n_vertex, int colormap[], int conflict_vid[])
+	{
+		return Greedy::detect_conflicts<1>(g, n_vertex, colormap, conflict_vid);
+	}
+
+	template <typename G>
+	inline report color_graph_seq(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		return Greedy::color_graph_seq<1>(g, n_vertex, colormap, order);
+	}
+
+	template <typename G>
+	inline report color_graph_par(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		return Greedy::color_graph_par<1>(g, n_vertex, colormap, order);
+	}
+
+	template <typename G>
+	inline report repair(const G &g, vertex_t n_vertex, int colormap[], const int touched[], int n_touched, int n_color)
+	{
+		return Greedy::repair<1>(g, n_vertex, colormap, touched, n_touched, n_color);
+	}
+}
+
+/**
+ * @brief Distance-2 coloring, vertices sharing a neighbor also get different colors
+ */
+namespace D2Coloring
+{
+	template <typename G>
+	inline int detect_conflicts(const G &g, vertex_t n_vertex, int colormap[], int conflict_vid[])
+	{
+		return Greedy::detect_conflicts<2>(g, n_vertex, colormap, conflict_vid);
+	}
+
+	template <typename G>
+	inline report color_graph_seq(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		return Greedy::color_graph_seq<2>(g, n_vertex, colormap, order);
+	}
+
+	template <typename G>
+	inline report color_graph_par(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		return Greedy::color_graph_par<2>(g, n_vertex, colormap, order);
+	}
+
+	template <typename G>
+	inline report repair(const G &g, vertex_t n_vertex, int colormap[], const int touched[], int n_touched, int n_color)
+	{
+		return Greedy::repair<2>(g, n_vertex, colormap, touched, n_touched, n_color);
+	}
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef ITERATED_H
+#define ITERATED_H
+
+#include "utils/graph.h"
+#include "utils/colorset.h"
+#include "utils/colorio.h"
+#include "greedy.h"
+#include "ordering.h"
+#include "report.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Iterated greedy (Culberson) recoloring, lowers the color count of a coloring after the first pass
+ *
+ * First fit over the vertices grouped by color class, the classes in any sequence, never
+ * needs more colors than the coloring it starts from: a vertex of the i-th class visited
+ * can always take one of the first i colors. Repeating it with different class sequences
+ * tends to merge classes away.
+ */
+namespace IteratedGreedy
+{
+	/**
+	 * @brief Whether name is a class sequence, reverse, largest, random or mixed
+	 */
+	inline bool is_class_order(const std::string &name)
+	{
+		return name == "reverse" || name == "largest" || name == "random" || name == "mixed";
+	}
+
+	/**
+	 * @brief Sequence to recolor the color classes in
+	 *
+	 * @param name: reverse (last color first), largest (largest class first), random,
+	 *              or mixed, which cycles through the three over the iterations
+	 * @param iteration: iteration number, seeds random
+	 * @param n_color: number of colors
+	 * @param class_ptr: class offsets shaped (n_color + 1, ), see color_classes
+	 * @param seq: output permutation of the colors shaped (n_color, )
+	 */
+	inline void class_sequence(const std::string &name, int iteration, int n_color, const vertex_t class_ptr[], int seq[])
+	{
+		const char *cycle[] = {"reverse", "largest", "random"};
+		std::string order = name == "mixed" ? cycle[iteration % 3] : name;
+
+		std::iota(seq, seq + n_color, 0);
+		if (order == "reverse")
+			std::reverse(seq, seq + n_color);
+		else if (order == "largest")
+			std::stable_sort(seq, seq + n_color, [&](int a, int b)
+			{
+				return class_ptr[a + 1] - class_ptr[a] > class_ptr[b + 1] - class_ptr[b];
+			});
+		else
+			std::sort(seq, seq + n_color, [&](int a, int b)
+			{
+				unsigned int ha = Ordering::hash(a, iteration + 1), hb = Ordering::hash(b, iteration + 1);
+				return ha < hb || (ha == hb && a < b);
+			});
+	}
+
+	/**
+	 * @brief Recolor by first fit in color class order, n_iteration times, keeping the best coloring
+	 *
+	 * The vertices of one class are never within the coloring distance of each other, so a
+	 * whole class is colored at once in parallel and the result is the one sequential first fit
+	 * gives in that order, whatever the number of threads. Classes go one after another,
+	 * separated by a barrier. Classes are bucketed with color_classes before every iteration.
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: valid coloring shaped (n_vertex, ), colors below n_color, improved in place
+	 * @param n_color: number of colors
+	 * @param n_iteration: number of recolorings
+	 * @param order: class sequence, see class_sequence
+	 * @return n_color is the number of colors after the last iteration, never more than given
+	 */
+	template <int distance, typename G>
+	report improve(const G &g, vertex_t n_vertex, int colormap[], int n_color, int n_iteration, const std::string &order)
+	{
+		report result;
+		double t_start, t_end;
+		std::vector<vertex_t> class_ptr(n_color + 1), class_vid(n_vertex);
+		std::vector<int> seq(n_color), next(n_vertex);
+		int *best = colormap, *trial = next.data();
+		Profile profile(omp_get_max_threads());
+
+		t_start = omp_get_wtime();
+		for (int it = 0; it < n_iteration && n_color > 1; it++)
+		{
+			if (color_classes(best, n_vertex, n_color, class_ptr.data(), class_vid.data()) != 0)
+				throw std::runtime_error("iterated greedy needs a complete coloring");
+			class_sequence(order, it, n_color, class_ptr.data(), seq.data());
+
+			int n_trial = 0;
+			#pragma omp parallel reduction(max : n_trial)
+			{
+				ColorSet forbidden(n_color + 1);
+				double t_phase = omp_get_wtime();
+				long long n_edge = 0;
+
+				#pragma omp for
+				for (vertex_t v = 0; v < n_vertex; v++)
+					trial[v] = -1;
+
+				for (int k = 0; k < n_color; k++)
+				{
+					int c = seq[k];
+					#pragma omp for schedule(dynamic, 64)
+					for (vertex_t i = class_ptr[c]; i < class_ptr[c + 1]; i++)
+					{
+						int vid = class_vid[i];
+						int color = Greedy::firstfit<distance>(vid, g, trial, forbidden, n_edge);
+						trial[vid] = color;
+						n_trial = std::max(n_trial, color + 1);
+					}
+				}
+				profile.record("iterate", it, n_vertex, t_phase, n_edge);
+			}
+
+			// never worse in theory, checked so a regression cannot slip through
+			if (n_trial <= n_color)
+			{
+				std::swap(best, trial);
+				n_color = n_trial;
+			}
+		}
+
+		if (best != colormap)
+		{
+			#pragma omp parallel for
+			for (vertex_t v = 0; v < n_vertex; v++)
+				colormap[v] = best[v];
+		}
+		t_end = omp_get_wtime();
+
+		result.n_color = n_color;
+		result.t_exec = t_end - t_start;
+		result.n_conflict = 0;
+		result.phases = profile.phases();
+		return result;
+	}
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef JONES_PLASSMANN_H
+#define JONES_PLASSMANN_H
+
+#include "utils/graph.h"
+#include "utils/colorset.h"
+#include "adjacency.h"
+#include "report.h"
+#include "greedy.h"
+#include "ordering.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Jones-Plassmann coloring
+ *
+ * Every vertex gets a pseudo-random priority derived from its id, or its rank in a given
+ * ordering. A vertex is colored once all its neighbors of higher priority are, so each
+ * round colors an independent set and no conflicts ever arise. The result equals first fit in decreasing priority order,
+ * whatever the number of threads.
+ */
+namespace JonesPlassmann
+{
+	/**
+	 * @brief Fill priorities, a hash of the id or the reversed rank in order
+	 *
+	 * Must be called by every thread of an enclosing parallel region.
+	 *
+	 * @param n_vertex: number of vertices
+	 * @param order: sequence to color vertices in, nullptr for pseudo-random
+	 * @param prio: output priorities shaped (n_vertex, )
+	 */
+	inline void priority_ws(vertex_t n_vertex, int order[], unsigned int prio[])
+	{
+		#pragma omp for
+		for (int i = 0; i < n_vertex; i++)
+		{
+			if (order)
+				prio[order[i]] = n_vertex - i;
+			else
+				prio[i] = Ordering::hash(i);
+		}
+	}
+
+	/**
+	 * @brief Whether u goes before v, ties in priority are broken by id
+	 */
+	inline bool precedes(int u, int v, unsigned int prio[])
+	{
+		return prio[u] > prio[v] || (prio[u] == prio[v] && u > v);
+	}
+
+	/**
+	 * @brief Color the graph sequentially, first fit in decreasing priority order
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: color array shaped (n_vertex, ), all -1
+	 * @param order: sequence to color vertices in, nullptr for pseudo-random
+	 */
+	template <int distance, typename G>
+	report color_graph_seq(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		report result;
+		double t_start, t_end;
+		int n_color = 0;
+		long long n_edge = 0;
+		int *sequence = new int[n_vertex];
+		ColorSet forbidden(Greedy::max_degree<distance>(g, n_vertex) + 1);
+		Profile profile(1);
+
+		t_start = omp_get_wtime();
+		if (order)
+			std::copy(order, order + n_vertex, sequence);
+		else
+		{
+			unsigned int *prio = new unsigned int[n_vertex];
+			for (int i = 0; i < n_vertex; i++)
+				prio[i] = Ordering::hash(i);
+			std::iota(sequence, sequence + n_vertex, 0);
+			std::sort(sequence, sequence + n_vertex, [&](int u, int v) { return precedes(u, v, prio); });
+			delete[] prio;
+		}
+
+		double t_color = omp_get_wtime();
+		for (int i = 0; i < n_vertex; i++)
+		{
+			int c = Greedy::firstfit<distance>(sequence[i], g, colormap, forbidden, n_edge);
+			colormap[sequence[i]] = c;
+			if (c > n_color)
+				n_color = c;
+		}
+		profile.record("color", 0, n_vertex, t_color, n_edge);
+		t_end = omp_get_wtime();
+
+		delete[] sequence;
+		result.n_color = n_color + 1;
+		result.t_exec = t_end - t_start;
+		result.n_conflict = 0;
+		result.phases = profile.phases();
+
+		return result;
+	}
+
+	/**
+	 * @brief Color the graph in parallel, one independent set of ready vertices per round
+	 *
+	 * Every vertex counts the neighbors that go before it. Coloring a vertex decrements the count of the
+	 * neighbors it goes before, and those reaching zero are colored in the next round. Vertices of one
+	 * round are never within the coloring distance of each other, so they only see colors of earlier rounds.
+	 *
+	 * @param g: adjacency view
+	 * @param n_vertex: number of vertices
+	 * @param colormap: color array shaped (n_vertex, ), all -1
+	 * @param order: sequence to color vertices in, nullptr for pseudo-random
+	 */
+	template <int distance, typename G>
+	report color_graph_par(const G &g, vertex_t n_vertex, int colormap[], int order[] = nullptr)
+	{
+		report result;
+		double t_start, t_end;
+
+		// vertices ready in this round and in the next one
+		int *work = new int[n_vertex];
+		int *next = new int[n_vertex];
+		edge_t *waiting = new edge_t[n_vertex];
+		unsigned int *prio = new unsigned int[n_vertex];
+		unsigned int *offset = new unsigned int[omp_get_max_threads() + 1]();
+		int n_forbidden = Greedy::max_degree<distance>(g, n_vertex) + 1;
+		Profile profile(omp_get_max_threads());
+
+		t_start = omp_get_wtime();
+		#pragma omp parallel
+		{
+			// per-thread scratch for firstfit and the next round
+			ColorSet forbidden(n_forbidden);
+			std::vector<int> local;
+			double t_phase = omp_get_wtime();
+			long long n_edge = 0;
+			int round = 0;
+
+			priority_ws(n_vertex, order, prio);
+
+			#pragma omp for schedule(static) nowait
+			for (int i = 0; i < n_vertex; i++)
+			{
+				edge_t n_before = 0;
+				Greedy::visit_neighbors<distance>(i, g, [&](int u)
+				{
+					n_before += precedes(u, i, prio);
+					n_edge++;
+					return false;
+				});
+				waiting[i] = n_before;
+				if (n_before == 0)
+					local.push_back(i);
+			}
+			profile.record("init", 0, n_vertex, t_phase, n_edge);
+			unsigned int n_work = Greedy::concat_ws(local, offset, work);
+
+			while (n_work > 0)
+			{
+				local.clear();
+				t_phase = omp_get_wtime();
+				n_edge = 0;
+				#pragma omp for nowait
+				for (unsigned int w = 0; w < n_work; w++)
+				{
+					int vid = work[w];
+					colormap[vid] = Greedy::firstfit<distance>(vid, g, colormap, forbidden, n_edge);
+
+					Greedy::visit_neighbors<distance>(vid, g, [&](int u)
+					{
+						n_edge++;
+						if (precedes(vid, u, prio))
+						{
+							edge_t left;
+							#pragma omp atomic capture
+							left = --waiting[u];
+							if (left == 0)
+								local.push_back(u);
+						}
+						return false;
+					});
+				}
+				profile.record("color", round++, n_work, t_phase, n_edge);
+				n_work = Greedy::concat_ws(local, offset, next);
+
+				#pragma omp single
+				std::swap(work, next);
+			}
+		}
+		t_end = omp_get_wtime();
+
+		// clean up
+		delete[] offset;
+		delete[] prio;
+		delete[] waiting;
+		delete[] next;
+		delete[] work;
+		result.n_color = max(n_vertex, colormap);
+		result.t_exec = t_end - t_start;
+		result.n_conflict = 0;
+		result.phases = profile.phases();
+		return result;
+	}
+}
+
+#endif
@@ -0,0 +1,323 @@
+#include "libcoloring.h"
+#include "utils/graphio.h"
+#include "utils/colorio.h"
+#include "adjacency.h"
+#include "engine.h"
+#include "ordering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Graph handle of the C API
+ *
+ * @param csr: adjacency, borrowed or owned
+ * @param n_vertex: number of vertices
+ * @param owned: csr and the weights were read by read_graph and are released with the handle
+ * @param order: orderings computed so far, indexed by COLORING_ ordering, empty until asked for
+ */
+struct coloring_graph
+{
+	Adjacency::Csr csr;
+	vertex_t n_vertex;
+	bool owned;
+	eweight_t *ew;
+	vweight_t *vw;
+	std::vector<int> order[COLORING_RANDOM + 1];
+};
+
+namespace
+{
+	const char *ordering_names[] = {"natural", "lf", "sl", "id", "random"};
+	const char *class_order_names[] = {"mixed", "reverse", "largest", "random"};
+
+	/**
+	 * @brief Restores the OpenMP thread count of the caller when going out of scope
+	 */
+	struct thread_scope
+	{
+		int saved = omp_get_max_threads();
+		explicit thread_scope(int n_thread)
+		{
+			if (n_thread > 0)
+				omp_set_num_threads(n_thread);
+		}
+		~thread_scope() { omp_set_num_threads(saved); }
+	};
+
+	/**
+	 * @brief Copy and validate the options of the caller, those of an older caller are completed with the defaults
+	 *
+	 * @return false on invalid options, or options of a newer caller
+	 */
+	bool read_options(const coloring_options *options, coloring_options *opt)
+	{
+		if (!options || options->size < sizeof(size_t) || options->size > sizeof(coloring_options))
+			return false;
+		coloring_options_init(opt);
+		memcpy(opt, options, options->size);
+		return (opt->distance == 1 || opt->distance == 2) &&
+			   (opt->algorithm == COLORING_SPECULATIVE || opt->algorithm == COLORING_JONES_PLASSMANN) &&
+			   opt->ordering >= COLORING_NATURAL && opt->ordering <= COLORING_RANDOM && opt->n_thread >= 0 &&
+			   opt->n_iteration >= 0 && opt->class_order >= COLORING_CLASS_MIXED && opt->class_order <= COLORING_CLASS_RANDOM;
+	}
+
+	/**
+	 * @brief Whether a result of the caller has room for the field ending at end, fields are only ever appended
+	 */
+	bool has_field(const coloring_result *result, size_t end)
+	{
+		return result->size >= end;
+	}
+
+	/**
+	 * @brief Whether result is NULL or at least as large as the first version, size, counts and t_exec
+	 */
+	bool valid_result(const coloring_result *result)
+	{
+		return !result || has_field(result, offsetof(coloring_result, t_exec) + sizeof(double));
+	}
+}
+
+void coloring_options_init(coloring_options *opt)
+{
+	opt->size = sizeof(coloring_options);
+	opt->algorithm = COLORING_SPECULATIVE;
+	opt->distance = 2;
+	opt->ordering = COLORING_NATURAL;
+	opt->n_thread = 0;
+	opt->check = 1;
+	opt->balance = 0;
+	opt->n_iteration = 0;
+	opt->class_order = COLORING_CLASS_MIXED;
+}
+
+void coloring_result_init(coloring_result *result)
+{
+	result->size = sizeof(coloring_result);
+	result->n_color = 0;
+	result->n_fix = 0;
+	result->n_conflict = -1;
+	result->t_exec = 0;
+	result->class_imbalance = NAN;
+	result->n_recolored = 0;
+}
+
+int coloring_graph_wrap(vertex_t n_vertex, const edge_t *xadj, const vertex_t *adj, coloring_graph **g)
+{
+	if (n_vertex < 0 || !xadj || !adj || !g)
+		return COLORING_EINVAL;
+	// the kernels only read the arrays, the view is just not const-qualified
+	*g = new (std::nothrow) coloring_graph{{const_cast<edge_t *>(xadj), const_cast<vertex_t *>(adj)}, n_vertex,
+										   false, nullptr, nullptr, {}};
+	return *g ? COLORING_OK : COLORING_ENOMEM;
+}
+
+int coloring_graph_load(const char *path, coloring_graph **g)
+{
+	if (!path || !g)
+		return COLORING_EINVAL;
+
+	edge_t *xadj;
+	vertex_t *adj;
+	eweight_t *ew;
+	vweight_t *vw;
+	vertex_t n_vertex;
+	std::string gpath = path;
+	if (read_graph(&gpath[0], &xadj, &adj, &ew, &vw, &n_vertex, 0, GRAPH_WILLNEED | GRAPH_STRUCTURE) == -1)
+		return COLORING_EIO;
+
+	*g = new (std::nothrow) coloring_graph{{xadj, adj}, n_vertex, true, ew, vw, {}};
+	if (!*g)
+	{
+		free_graph(xadj, adj, ew, vw);
+		return COLORING_ENOMEM;
+	}
+	return COLORING_OK;
+}
+
+void coloring_graph_free(coloring_graph *g)
+{
+	if (!g)
+		return;
+	if (g->owned)
+		free_graph(g->csr.row, g->csr.col, g->ew, g->vw);
+	delete g;
+}
+
+vertex_t coloring_graph_n_vertex(const coloring_graph *g)
+{
+	return g ? g->n_vertex : -1;
+}
+
+int coloring_color(coloring_graph *g, const coloring_options *options, int *colormap, coloring_result *result)
+{
+	coloring_options o;
+	const coloring_options *opt = &o;
+	if (!g || !colormap || !read_options(options, &o) || !valid_result(result))
+		return COLORING_EINVAL;
+
+	try
+	{
+		thread_scope threads(opt->n_thread);
+
+		int *order = nullptr;
+		if (opt->ordering != COLORING_NATURAL)
+		{
+			std::vector<int> &cached = g->order[opt->ordering];
+			if (cached.empty() && g->n_vertex > 0)
+			{
+				cached.resize(g->n_vertex);
+				Ordering::compute(ordering_names[opt->ordering], g->csr.row, g->csr.col, g->n_vertex, cached.data());
+			}
+			order = cached.data();
+		}
+
+		engine<Adjacency::Csr> coloring = select_engine<Adjacency::Csr>(
+			opt->distance, opt->algorithm == COLORING_JONES_PLASSMANN ? "jp" : "spec");
+		std::fill_n(colormap, g->n_vertex, -1);
+		report r = opt->n_thread == 1 ? coloring.color_graph_seq(g->csr, g->n_vertex, colormap, order)
+									  : coloring.color_graph_par(g->csr, g->n_vertex, colormap, order);
+		if (opt->n_iteration > 0)
+		{
+			report b = coloring.improve(g->csr, g->n_vertex, colormap, r.n_color, opt->n_iteration,
+										class_order_names[opt->class_order]);
+			r.t_exec += b.t_exec;
+			r.n_color = b.n_color;
+		}
+		if (opt->balance)
+		{
+			report b = coloring.balance(g->csr, g->n_vertex, colormap, r.n_color, BALANCE_ROUNDS);
+			r.t_exec += b.t_exec;
+			r.class_imbalance = b.class_imbalance;
+		}
+
+		if (result)
+		{
+			result->n_color = r.n_color;
+			result->n_fix = r.n_conflict;
+			result->n_conflict = opt->check ? (int)coloring_check(g, opt->distance, colormap) : -1;
+			result->t_exec = r.t_exec;
+			if (has_field(result, offsetof(coloring_result, class_imbalance) + sizeof(double)))
+				result->class_imbalance = std::isnan(r.class_imbalance)
+											  ? class_imbalance(g->n_vertex, colormap, r.n_color)
+											  : r.class_imbalance;
+			if (has_field(result, offsetof(coloring_result, n_recolored) + sizeof(int)))
+				result->n_recolored = 0;
+		}
+	}
+	catch (const std::bad_alloc &)
+	{
+		return COLORING_ENOMEM;
+	}
+	catch (const std::exception &)
+	{
+		// nothing may unwind into a C caller
+		return COLORING_EINTERNAL;
+	}
+	return COLORING_OK;
+}
+
+int coloring_repair(coloring_graph *g, const coloring_options *options, const vertex_t *edges, size_t n_insert,
+					vertex_t n_added, int n_color, int *colormap, coloring_result *result)
+{
+	coloring_options o;
+	const coloring_options *opt = &o;
+	if (!g || !colormap || (n_insert > 0 && !edges) || n_added < 0 || n_added > g->n_vertex || n_color < 0 ||
+		!read_options(options, &o) || !valid_result(result))
+		return COLORING_EINVAL;
+	for (size_t i = 0; i < 2 * n_insert; i++)
+		if (edges[i] < 0 || edges[i] >= g->n_vertex)
+			return COLORING_EINVAL;
+
+	try
+	{
+		thread_scope threads(opt->n_thread);
+
+		std::vector<int> touched(edges, edges + 2 * n_insert);
+		for (vertex_t v = g->n_vertex - n_added; v < g->n_vertex; v++)
+		{
+			colormap[v] = -1;
+			touched.push_back(v);
+		}
+		if (n_color == 0)
+			n_color = max(g->n_vertex - n_added, colormap);
+
+		report r = opt->distance == 1
+					   ? D1Coloring::repair(g->csr, g->n_vertex, colormap, touched.data(), touched.size(), n_color)
+					   : D2Coloring::repair(g->csr, g->n_vertex, colormap, touched.data(), touched.size(), n_color);
+
+		if (result)
+		{
+			result->n_color = r.n_color;
+			result->n_fix = r.n_conflict;
+			result->n_conflict = opt->check ? (int)coloring_check(g, opt->distance, colormap) : -1;
+			result->t_exec = r.t_exec;
+			if (has_field(result, offsetof(coloring_result, class_imbalance) + sizeof(double)))
+				result->class_imbalance = NAN;
+			if (has_field(result, offsetof(coloring_result, n_recolored) + sizeof(int)))
+				result->n_recolored = r.n_recolored;
+		}
+	}
+	catch (const std::bad_alloc &)
+	{
+		return COLORING_ENOMEM;
+	}
+	catch (const std::exception &)
+	{
+		// nothing may unwind into a C caller
+		return COLORING_EINTERNAL;
+	}
+	return COLORING_OK;
+}
+
+long long coloring_check(const coloring_graph *g, int distance, const int *colormap)
+{
+	if (!g || !colormap || (distance != 1 && distance != 2))
+		return -1;
+
+	try
+	{
+		std::vector<int> conflict_vid(g->n_vertex);
+		int *c = const_cast<int *>(colormap);
+		return distance == 1 ? D1Coloring::detect_conflicts(g->csr, g->n_vertex, c, conflict_vid.data())
+							 : D2Coloring::detect_conflicts(g->csr, g->n_vertex, c, conflict_vid.data());
+	}
+	catch (const std::exception &)
+	{
+		return -1;
+	}
+}
+
+int coloring_write(const coloring_graph *g, const int *colormap, const char *path)
+{
+	if (!g || !colormap || !path || std::any_of(colormap, colormap + g->n_vertex, [](int c) { return c < 0; }))
+		return COLORING_EINVAL;
+	return write_coloring(path, colormap, g->n_vertex) == 0 ? COLORING_OK : COLORING_EIO;
+}
+
+const char *coloring_strerror(int code)
+{
+	switch (code)
+	{
+	case COLORING_OK:
+		return "success";
+	case COLORING_EINVAL:
+		return "invalid argument";
+	case COLORING_ENOMEM:
+		return "out of memory";
+	case COLORING_EIO:
+		return "file missing, unreadable or unwritable";
+	case COLORING_EINTERNAL:
+		return "internal error in a coloring kernel";
+	default:
+		return "unknown error";
+	}
+}
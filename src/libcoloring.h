@@ -0,0 +1,213 @@
+#ifndef LIBCOLORING_H
+#define LIBCOLORING_H
+
+#include <stddef.h>
+#include "utils/graph.h"
+
+/*
+ * C API of libcoloring, for callers that color a CSR graph they hold in memory.
+ *
+ * A graph handle borrows the caller's arrays, or owns a graph read from a file,
+ * and keeps what is derived from the graph, vertex orderings for now, across
+ * colorings. Options and results are versioned by their size, so a caller built
+ * against an older header keeps working: always start from coloring_options_init
+ * and coloring_result_init.
+ * Index widths follow utils/graph.h, build with the same -DEDGE64 as the library.
+ * A handle must not be used by two threads at once, different handles may.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* error codes, every call returns COLORING_OK or one of them */
+#define COLORING_OK 0
+#define COLORING_EINVAL -1 /* bad argument or option */
+#define COLORING_ENOMEM -2 /* out of memory */
+#define COLORING_EIO -3 /* file missing, unreadable or unwritable */
+#define COLORING_EINTERNAL -4 /* a kernel failed, e.g. ran out of colors or exceeded an index limit, colormap is undefined */
+
+/* algorithms */
+#define COLORING_SPECULATIVE 0 /* speculative first fit with conflict rounds */
+#define COLORING_JONES_PLASSMANN 1 /* same coloring for any number of threads */
+
+/* vertex orderings */
+#define COLORING_NATURAL 0
+#define COLORING_LARGEST_FIRST 1
+#define COLORING_SMALLEST_LAST 2
+#define COLORING_INCIDENCE_DEGREE 3
+#define COLORING_RANDOM 4
+
+/* class sequences of the iterated greedy recoloring */
+#define COLORING_CLASS_MIXED 0 /* cycles through the three below */
+#define COLORING_CLASS_REVERSE 1
+#define COLORING_CLASS_LARGEST 2
+#define COLORING_CLASS_RANDOM 3
+
+typedef struct coloring_graph coloring_graph;
+
+/*
+ * size: sizeof(coloring_options) of the caller, set by coloring_options_init
+ * algorithm: COLORING_SPECULATIVE (default) or COLORING_JONES_PLASSMANN
+ * distance: 1 or 2 (default)
+ * ordering: COLORING_NATURAL (default) or another ordering, by distance-1 degrees at either distance
+ * n_thread: threads to color with, 0 (default) for the OpenMP default, 1 for the sequential kernel
+ * check: count the conflicts left in the result, 1 by default
+ * balance: even out the color class sizes after coloring without adding colors, 0 by default
+ * n_iteration: iterated greedy recolorings in color class order after coloring, never adding colors, 0 by default
+ * class_order: class sequence of the recolorings, COLORING_CLASS_MIXED (default) or another one
+ */
+typedef struct coloring_options {
+	size_t size;
+	int algorithm;
+	int distance;
+	int ordering;
+	int n_thread;
+	int check;
+	int balance;
+	int n_iteration;
+	int class_order;
+} coloring_options;
+
+/*
+ * size: sizeof(coloring_result) of the caller, set by coloring_result_init, fields past it are not written
+ * n_color: number of colors, colors are 0 .. n_color - 1
+ * n_fix: rounds spent fixing conflicts, by the speculative algorithm or coloring_repair, 0 for Jones-Plassmann
+ * n_conflict: conflicts left, 0 unless the kernel is broken, -1 when not checked
+ * t_exec: coloring time in seconds, orderings computed on the way excluded, recoloring and balancing included
+ * class_imbalance: largest color class over the mean class size, 1 when perfectly balanced, NAN from coloring_repair
+ * n_recolored: vertices coloring_repair recolored, added vertices included, 0 from coloring_color
+ */
+typedef struct coloring_result {
+	size_t size;
+	int n_color;
+	int n_fix;
+	int n_conflict;
+	double t_exec;
+	double class_imbalance;
+	int n_recolored;
+} coloring_result;
+
+void coloring_options_init(coloring_options * opt);
+
+void coloring_result_init(coloring_result * result);
+
+/* wrap a symmetric CSR graph without copying it, the arrays must outlive the handle and stay unchanged */
+int coloring_graph_wrap(vertex_t n_vertex, const edge_t * xadj, const vertex_t * adj, coloring_graph ** g);
+
+/* read a graph file or generator spec as read_graph does, the handle owns it */
+int coloring_graph_load(const char * path, coloring_graph ** g);
+
+void coloring_graph_free(coloring_graph * g);
+
+vertex_t coloring_graph_n_vertex(const coloring_graph * g);
+
+/* color g into colormap, shaped (n_vertex, ) and allocated by the caller, result may be NULL or from coloring_result_init */
+int coloring_color(coloring_graph * g, const coloring_options * opt, int * colormap, coloring_result * result);
+
+/*
+ * Repair colormap after edges were inserted into the graph or vertices appended to it, g being the
+ * graph after the change. edges holds the n_insert inserted edges as (u, v) pairs, removed edges are
+ * not passed since removing one never breaks a coloring. The last n_added vertices of g are new and
+ * their colors in colormap are ignored. n_color is the number of colors of colormap before the change,
+ * as returned by coloring_color, or 0 to count them. Only the endpoints, the added vertices and their
+ * neighborhoods are read, unless opt->check asks to check the whole result, which reads all of g.
+ * The algorithm and ordering of opt are not used.
+ */
+int coloring_repair(coloring_graph * g, const coloring_options * opt, const vertex_t * edges, size_t n_insert,
+	vertex_t n_added, int n_color, int * colormap, coloring_result * result);
+
+/* conflicts of a coloring at a distance, -1 on a bad argument or failure */
+long long coloring_check(const coloring_graph * g, int distance, const int * colormap);
+
+/* write colormap and its color classes to path in the mappable layout of utils/colorio.h */
+int coloring_write(const coloring_graph * g, const int * colormap, const char * path);
+
+const char * coloring_strerror(int code);
+
+#ifdef __cplusplus
+}
+
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief C++ view of the C API, errors are thrown as std::runtime_error
+ */
+namespace Coloring
+{
+	class Graph
+	{
+	public:
+		/**
+		 * @brief Wrap a symmetric CSR graph without copying it, the arrays must outlive the graph
+		 */
+		Graph(vertex_t n_vertex, const edge_t *xadj, const vertex_t *adj)
+		{
+			check(coloring_graph_wrap(n_vertex, xadj, adj, &g));
+		}
+
+		/**
+		 * @brief Read a graph file or generator spec
+		 */
+		explicit Graph(const char *path) { check(coloring_graph_load(path, &g)); }
+
+		~Graph() { coloring_graph_free(g); }
+
+		Graph(const Graph &) = delete;
+		Graph &operator=(const Graph &) = delete;
+
+		vertex_t n_vertex() const { return coloring_graph_n_vertex(g); }
+
+		/**
+		 * @brief Color into colormap, resized to n_vertex
+		 */
+		coloring_result color(std::vector<int> &colormap, const coloring_options &opt) const
+		{
+			coloring_result r;
+			coloring_result_init(&r);
+			colormap.resize(n_vertex());
+			check(coloring_color(g, &opt, colormap.data(), &r));
+			return r;
+		}
+
+		coloring_result color(std::vector<int> &colormap) const
+		{
+			coloring_options opt;
+			coloring_options_init(&opt);
+			return color(colormap, opt);
+		}
+
+		/**
+		 * @brief Repair colormap, colored before inserting edges (u, v) pairs and appending n_added vertices
+		 */
+		coloring_result repair(std::vector<int> &colormap, const std::vector<vertex_t> &edges, vertex_t n_added,
+							   int n_color, const coloring_options &opt) const
+		{
+			coloring_result r;
+			coloring_result_init(&r);
+			colormap.resize(n_vertex(), -1);
+			check(coloring_repair(g, &opt, edges.data(), edges.size() / 2, n_added, n_color, colormap.data(), &r));
+			return r;
+		}
+
+		void write(const std::vector<int> &colormap, const char *path) const
+		{
+			check(coloring_write(g, colormap.data(), path));
+		}
+
+		coloring_graph *handle() const { return g; }
+
+	private:
+		coloring_graph *g = nullptr;
+
+		static void check(int code)
+		{
+			if (code != COLORING_OK)
+				throw std::runtime_error(coloring_strerror(code));
+		}
+	};
+}
+#endif
+
+#endif
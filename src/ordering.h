@@ -0,0 +1,315 @@
+#ifndef ORDERING_H
+#define ORDERING_H
+
+#include "utils/graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <omp.h>
+
+/**
+ * @brief Vertex orderings for first fit
+ *
+ * Every ordering writes a permutation of the vertex ids into order, the coloring
+ * kernels then visit vertices in that sequence instead of by index. Degrees are those
+ * of the graph as given, also for distance-2 coloring: the square graph is never
+ * materialized whole, so its degrees are not known ahead of the coloring.
+ */
+namespace Ordering
+{
+	/**
+	 * @brief Pseudo-random 32-bit hash of a vertex id
+	 *
+	 * @param vid: vertex id
+	 * @param seed: hash seed
+	 */
+	inline unsigned int hash(unsigned int vid, unsigned int seed = 0x9e3779b9u)
+	{
+		unsigned int x = vid ^ seed;
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	/**
+	 * @brief Parallel counting sort of the vertex ids by key, ties are ordered by less
+	 *
+	 * Buckets are counted and filled with atomics, then every bucket is sorted on its own,
+	 * so the result does not depend on the number of threads.
+	 *
+	 * @param key: bucket of each vertex, in [0, n_key)
+	 * @param n_key: number of buckets
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 * @param less: strict order within a bucket
+	 */
+	template <typename Less = std::less<int>>
+	void counting_sort(int key[], int n_key, vertex_t n_vertex, int order[], Less less = Less())
+	{
+		int *start = new int[n_key + 1]();
+		int *fill = new int[n_key];
+
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+		{
+			#pragma omp atomic
+			start[key[i] + 1]++;
+		}
+
+		for (int k = 0; k < n_key; k++)
+			start[k + 1] += start[k];
+		std::copy(start, start + n_key, fill);
+
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+		{
+			int pos;
+			#pragma omp atomic capture
+			pos = fill[key[i]]++;
+			order[pos] = i;
+		}
+
+		#pragma omp parallel for schedule(dynamic, 64)
+		for (int k = 0; k < n_key; k++)
+			std::sort(order + start[k], order + start[k + 1], less);
+
+		delete[] fill;
+		delete[] start;
+	}
+
+	/**
+	 * @brief Largest degree first, ties by id
+	 *
+	 * @param row: row pointer
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 */
+	inline void largest_first(edge_t *row, vertex_t n_vertex, int order[])
+	{
+		int *key = new int[n_vertex];
+		int max_deg = 0;
+
+		#pragma omp parallel for reduction(max : max_deg)
+		for (int i = 0; i < n_vertex; i++)
+		{
+			key[i] = row[i + 1] - row[i];
+			max_deg = std::max(max_deg, key[i]);
+		}
+
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+			key[i] = max_deg - key[i];
+
+		counting_sort(key, max_deg + 1, n_vertex, order);
+		delete[] key;
+	}
+
+	/**
+	 * @brief Uniformly shuffled, ordered by a hash of the vertex id
+	 *
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 * @param seed: hash seed
+	 */
+	inline void random(vertex_t n_vertex, int order[], unsigned int seed = 0x9e3779b9u)
+	{
+		// bucket by the top bits, then sort within a bucket by the full hash
+		int bits = 1;
+		while (bits < 16 && (1 << bits) < n_vertex)
+			bits++;
+		int *key = new int[n_vertex];
+
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+			key[i] = hash(i, seed) >> (32 - bits);
+
+		counting_sort(key, 1 << bits, n_vertex, order, [&](int u, int v)
+		{
+			unsigned int hu = hash(u, seed), hv = hash(v, seed);
+			return hu < hv || (hu == hv && u < v);
+		});
+		delete[] key;
+	}
+
+	/**
+	 * @brief Smallest last, the reverse of repeatedly removing a vertex of minimum remaining degree
+	 *
+	 * Peeling is inherently sequential, a bucket queue of doubly linked lists keeps it O(|V| + |E|):
+	 * a removal lowers the minimum by one at most. Every remaining neighbor loses one degree, unlike
+	 * the core decomposition of Batagelj and Zaversnik which stops lowering at the current core.
+	 *
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 */
+	inline void smallest_last(edge_t *row, vertex_t *col, vertex_t n_vertex, int order[])
+	{
+		int max_deg = 0;
+		int *key = new int[n_vertex];
+		#pragma omp parallel for reduction(max : max_deg)
+		for (int i = 0; i < n_vertex; i++)
+		{
+			key[i] = row[i + 1] - row[i];
+			max_deg = std::max(max_deg, key[i]);
+		}
+
+		int *next = new int[n_vertex];
+		int *prev = new int[n_vertex];
+		int *head = new int[max_deg + 1];
+		std::fill_n(head, max_deg + 1, -1);
+
+		auto push = [&](int v)
+		{
+			prev[v] = -1;
+			next[v] = head[key[v]];
+			if (head[key[v]] >= 0)
+				prev[head[key[v]]] = v;
+			head[key[v]] = v;
+		};
+		auto remove = [&](int v)
+		{
+			if (prev[v] >= 0)
+				next[prev[v]] = next[v];
+			else
+				head[key[v]] = next[v];
+			if (next[v] >= 0)
+				prev[next[v]] = prev[v];
+		};
+
+		// pushed in reverse, so ties are removed by increasing id
+		for (int i = n_vertex - 1; i >= 0; i--)
+			push(i);
+
+		int bottom = 0;
+		for (int i = 0; i < n_vertex; i++)
+		{
+			while (head[bottom] < 0)
+				bottom++;
+			int v = head[bottom];
+			remove(v);
+			key[v] = -1;
+			order[n_vertex - 1 - i] = v;
+
+			for (edge_t j = row[v]; j < row[v + 1]; j++)
+			{
+				int u = col[j];
+				if (key[u] < 0)
+					continue;
+				remove(u);
+				key[u]--;
+				push(u);
+			}
+			bottom = std::max(bottom - 1, 0);
+		}
+
+		delete[] head;
+		delete[] prev;
+		delete[] next;
+		delete[] key;
+	}
+
+	/**
+	 * @brief Incidence degree, repeatedly take the vertex with the most already ordered neighbors
+	 *
+	 * Inherently sequential, a bucket queue of doubly linked lists keeps it O(|V| + |E|).
+	 *
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 */
+	inline void incidence_degree(edge_t *row, vertex_t *col, vertex_t n_vertex, int order[])
+	{
+		int max_deg = 0;
+		#pragma omp parallel for reduction(max : max_deg)
+		for (int i = 0; i < n_vertex; i++)
+			max_deg = std::max(max_deg, (int)(row[i + 1] - row[i]));
+
+		int *key = new int[n_vertex]();
+		int *next = new int[n_vertex];
+		int *prev = new int[n_vertex];
+		int *head = new int[max_deg + 1];
+		std::fill_n(head, max_deg + 1, -1);
+
+		auto push = [&](int v)
+		{
+			prev[v] = -1;
+			next[v] = head[key[v]];
+			if (head[key[v]] >= 0)
+				prev[head[key[v]]] = v;
+			head[key[v]] = v;
+		};
+		auto remove = [&](int v)
+		{
+			if (prev[v] >= 0)
+				next[prev[v]] = next[v];
+			else
+				head[key[v]] = next[v];
+			if (next[v] >= 0)
+				prev[next[v]] = prev[v];
+		};
+
+		// pushed in reverse, so ties are taken by increasing id
+		for (int i = n_vertex - 1; i >= 0; i--)
+			push(i);
+
+		int top = 0;
+		for (int i = 0; i < n_vertex; i++)
+		{
+			while (head[top] < 0)
+				top--;
+			int v = head[top];
+			remove(v);
+			key[v] = -1;
+			order[i] = v;
+
+			for (edge_t j = row[v]; j < row[v + 1]; j++)
+			{
+				int u = col[j];
+				if (key[u] < 0)
+					continue;
+				remove(u);
+				key[u]++;
+				push(u);
+				top = std::max(top, key[u]);
+			}
+		}
+
+		delete[] head;
+		delete[] prev;
+		delete[] next;
+		delete[] key;
+	}
+
+	/**
+	 * @brief Compute an ordering by name
+	 *
+	 * @param name: lf (largest first), sl (smallest last), id (incidence degree) or random
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param order: output permutation shaped (n_vertex, )
+	 * @return false if the name is unknown
+	 */
+	inline bool compute(const std::string &name, edge_t *row, vertex_t *col, vertex_t n_vertex, int order[])
+	{
+		if (name == "lf")
+			largest_first(row, n_vertex, order);
+		else if (name == "sl")
+			smallest_last(row, col, n_vertex, order);
+		else if (name == "id")
+			incidence_degree(row, col, n_vertex, order);
+		else if (name == "random")
+			random(n_vertex, order);
+		else
+			return false;
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "utils/graph.h"
+#include "utils/perf.h"
+#include "report.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// compiler flags of the build, passed in by the makefile
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS ""
+#endif
+
+/**
+ * @brief Machine-readable records of the runs, one per run
+ *
+ * JSON lines give every run a self-contained object with its phases as an array, CSV gives
+ * one row per run under a header, with the phases packed into one field. The first six CSV
+ * columns are the ones of the table, in the same order.
+ */
+namespace Output
+{
+	enum format
+	{
+		TABLE,
+		JSON,
+		CSV
+	};
+
+	/**
+	 * @brief Parse a format name, table, json or csv
+	 *
+	 * @return false if the name is unknown
+	 */
+	inline bool parse(const std::string &name, format *f)
+	{
+		if (name == "table")
+			*f = TABLE;
+		else if (name == "json")
+			*f = JSON;
+		else if (name == "csv")
+			*f = CSV;
+		else
+			return false;
+		return true;
+	}
+
+	/**
+	 * @brief Graph statistics and settings every record of a session repeats
+	 *
+	 * @param graph: path the graph was read from
+	 * @param n_vertex: number of vertices
+	 * @param n_edge: stored adjacency entries, every undirected edge counts twice
+	 * @param max_degree: largest degree
+	 * @param distance: coloring distance
+	 * @param algorithm: spec or jp
+	 * @param ordering: vertex ordering
+	 * @param reorder: relabeling
+	 * @param compressed: colored on the compressed adjacency
+	 * @param square_mb: square graph budget in MB, negative if none
+	 * @param n_warmup: unmeasured runs before the measured ones
+	 * @param pinned: threads pinned to cores
+	 * @param n_iteration: iterated greedy recolorings after every parallel coloring, 0 if none
+	 * @param class_order: class sequence of the iterated greedy recolorings
+	 * @param balanced: color classes balanced after every parallel coloring
+	 * @param t_reorder, t_order, t_compress, t_square: setup times shared by the runs, NAN if skipped
+	 */
+	typedef struct context
+	{
+		std::string graph;
+		vertex_t n_vertex;
+		edge_t n_edge;
+		edge_t max_degree;
+		int distance;
+		std::string algorithm;
+		std::string ordering;
+		std::string reorder;
+		bool compressed;
+		long long square_mb;
+		int n_warmup;
+		bool pinned;
+		int n_iteration;
+		std::string class_order;
+		bool balanced;
+		double t_reorder;
+		double t_order;
+		double t_compress;
+		double t_square;
+	} context;
+
+	// a JSON string body: quotes and backslashes escaped, control characters as \u00XX
+	inline std::string escape_json(const std::string &s)
+	{
+		std::string out;
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			if ((unsigned char)c < 0x20)
+			{
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+				out += code;
+				continue;
+			}
+			out += c;
+		}
+		return out;
+	}
+
+	// a quoted CSV field body as in RFC 4180: quotes doubled, anything else kept
+	inline std::string escape_csv(const std::string &s)
+	{
+		std::string out;
+		for (char c : s)
+		{
+			if (c == '"')
+				out += '"';
+			out += c;
+		}
+		return out;
+	}
+
+	// a real number, empty in csv or null in json when NAN
+	inline void print_real(FILE *out, double t, bool json)
+	{
+		if (std::isnan(t))
+			fputs(json ? "null" : "", out);
+		else
+			fprintf(out, "%.10f", t);
+	}
+
+	inline void print_csv_header(FILE *out)
+	{
+		fputs("method,n_threads,n_fixes,n_colors,time,n_conf,"
+			  "graph,n_vertex,n_edge,max_degree,distance,algorithm,ordering,reorder,compressed,square_mb,"
+			  "n_warmup,pinned,n_iteration,class_order,balanced,edge_bits,build,t_reorder,t_order,t_compress,t_square,"
+			  "n_runs,t_min,t_median,t_p95,t_mean,t_ci95,"
+			  "cycles,instructions,llc_misses,dtlb_misses,class_imbalance,phases\n",
+			  out);
+	}
+
+	/**
+	 * @brief Print the record of one run
+	 *
+	 * @param out: stream to print to
+	 * @param f: JSON or CSV
+	 * @param c: session the run belongs to
+	 * @param method: Sequential or Parallel
+	 * @param n_thread: number of threads
+	 * @param r: report of the run, the median one if repeated
+	 * @param t: times of the repeated runs
+	 * @param conflicts: conflicts left on the input graph, the most of any repetition
+	 * @param counters: hardware counters of the run, nullptr if not counted
+	 */
+	inline void print_record(FILE *out, format f, const context &c, const char *method, int n_thread,
+							 const report &r, const timing &t, int conflicts, const long long *counters)
+	{
+		bool json = f == JSON;
+		if (json)
+			fprintf(out, "{\"method\": \"%s\", \"n_threads\": %d, \"n_fixes\": %d, \"n_colors\": %d, \"time\": %.10f, "
+						 "\"n_conf\": %d, \"graph\": \"%s\", \"n_vertex\": %d, \"n_edge\": %llu, \"max_degree\": %llu, "
+						 "\"distance\": %d, \"algorithm\": \"%s\", \"ordering\": \"%s\", \"reorder\": \"%s\", "
+						 "\"compressed\": %s, \"square_mb\": %lld, \"n_warmup\": %d, \"pinned\": %s, "
+						 "\"n_iteration\": %d, \"class_order\": \"%s\", \"balanced\": %s, \"edge_bits\": %d, \"build\": \"%s\"",
+					method, n_thread, r.n_conflict, r.n_color, t.t_median, conflicts, escape_json(c.graph).c_str(),
+					c.n_vertex, (unsigned long long)c.n_edge, (unsigned long long)c.max_degree, c.distance,
+					c.algorithm.c_str(), c.ordering.c_str(), c.reorder.c_str(), c.compressed ? "true" : "false",
+					c.square_mb, c.n_warmup, c.pinned ? "true" : "false", c.n_iteration, c.class_order.c_str(),
+					c.balanced ? "true" : "false", (int)(8 * sizeof(edge_t)), escape_json(BUILD_FLAGS).c_str());
+		else
+			fprintf(out, "%s,%d,%d,%d,%.10f,%d,\"%s\",%d,%llu,%llu,%d,%s,%s,%s,%d,%lld,%d,%d,%d,%s,%d,%d,\"%s\"",
+					method, n_thread, r.n_conflict, r.n_color, t.t_median, conflicts, escape_csv(c.graph).c_str(),
+					c.n_vertex, (unsigned long long)c.n_edge, (unsigned long long)c.max_degree, c.distance,
+					c.algorithm.c_str(), c.ordering.c_str(), c.reorder.c_str(), (int)c.compressed,
+					c.square_mb, c.n_warmup, (int)c.pinned, c.n_iteration, c.class_order.c_str(), (int)c.balanced,
+					(int)(8 * sizeof(edge_t)), escape_csv(BUILD_FLAGS).c_str());
+
+		const char *setup_name[] = {"t_reorder", "t_order", "t_compress", "t_square"};
+		const double setup[] = {c.t_reorder, c.t_order, c.t_compress, c.t_square};
+		for (int i = 0; i < 4; i++)
+		{
+			if (json)
+				fprintf(out, ", \"%s\": ", setup_name[i]);
+			else
+				fputc(',', out);
+			print_real(out, setup[i], json);
+		}
+
+		if (json)
+			fprintf(out, ", \"n_runs\": %d, \"t_min\": %.10f, \"t_median\": %.10f, \"t_p95\": %.10f, \"t_mean\": %.10f, "
+						 "\"t_ci95\": %.10f",
+					t.n_run, t.t_min, t.t_median, t.t_p95, t.t_mean, t.t_ci95);
+		else
+			fprintf(out, ",%d,%.10f,%.10f,%.10f,%.10f,%.10f", t.n_run, t.t_min, t.t_median, t.t_p95, t.t_mean, t.t_ci95);
+
+		// counters the machine does not support are left out, as are all of them when not counted
+		const char *counter_name[PerfCounters::N_EVENT] = {"cycles", "instructions", "llc_misses", "dtlb_misses"};
+		for (int e = 0; e < PerfCounters::N_EVENT; e++)
+		{
+			bool known = counters && counters[e] >= 0;
+			if (json && known)
+				fprintf(out, ", \"%s\": %lld", counter_name[e], counters[e]);
+			else if (!json)
+			{
+				fputc(',', out);
+				if (known)
+					fprintf(out, "%lld", counters[e]);
+			}
+		}
+
+		if (json)
+			fprintf(out, ", \"class_imbalance\": ");
+		else
+			fputc(',', out);
+		print_real(out, r.class_imbalance, json);
+
+		fputs(json ? ", \"phases\": [" : ",\"", out);
+		for (size_t i = 0; i < r.phases.size(); i++)
+		{
+			const phase &p = r.phases[i];
+			if (json)
+				fprintf(out, "%s{\"name\": \"%s\", \"round\": %d, \"t_wall\": %.10f, \"n_vertex\": %lld, \"n_edge\": %lld, "
+							 "\"t_busy_max\": %.10f, \"t_busy_mean\": %.10f}",
+						i ? ", " : "", p.name, p.round, p.t_wall, p.n_vertex, p.n_edge, p.t_busy_max, p.t_busy_mean);
+			else
+				// name:round:t_wall:n_vertex:n_edge:t_busy_max:t_busy_mean, separated by semicolons
+				fprintf(out, "%s%s:%d:%.10f:%lld:%lld:%.10f:%.10f", i ? ";" : "", p.name, p.round, p.t_wall,
+						p.n_vertex, p.n_edge, p.t_busy_max, p.t_busy_mean);
+		}
+		fputs(json ? "]}\n" : "\"\n", out);
+		fflush(out);
+	}
+}
+
+#endif
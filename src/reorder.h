@@ -0,0 +1,196 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "utils/graph.h"
+#include "ordering.h"
+
+#include <algorithm>
+#include <string>
+#include <omp.h>
+
+/**
+ * @brief Graph relabeling for locality
+ *
+ * A permutation perm maps new ids to old ids, perm[new] = old. The graph is relabeled
+ * before coloring so that the neighbors walked by firstfit and detect_conflicts sit close
+ * together in col_ind and colormap, and the colormap is mapped back afterwards.
+ */
+namespace Reorder
+{
+	/**
+	 * @brief Breadth-first order, every component starts at its smallest id
+	 *
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param perm: output permutation shaped (n_vertex, )
+	 */
+	inline void bfs(edge_t *row, vertex_t *col, vertex_t n_vertex, int perm[])
+	{
+		bool *visited = new bool[n_vertex]();
+		int tail = 0;
+
+		// perm doubles as the queue
+		for (int s = 0; s < n_vertex; s++)
+		{
+			if (visited[s])
+				continue;
+			visited[s] = true;
+			perm[tail++] = s;
+
+			for (int head = tail - 1; head < tail; head++)
+			{
+				int v = perm[head];
+				for (edge_t j = row[v]; j < row[v + 1]; j++)
+				{
+					if (!visited[col[j]])
+					{
+						visited[col[j]] = true;
+						perm[tail++] = col[j];
+					}
+				}
+			}
+		}
+
+		delete[] visited;
+	}
+
+	/**
+	 * @brief Reverse Cuthill-McKee
+	 *
+	 * Every component is traversed breadth-first from its vertex of minimum degree, visiting
+	 * the neighbors of a vertex by increasing degree. The whole sequence is reversed at the end.
+	 *
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param perm: output permutation shaped (n_vertex, )
+	 */
+	inline void rcm(edge_t *row, vertex_t *col, vertex_t n_vertex, int perm[])
+	{
+		int *deg = new int[n_vertex];
+		int *by_degree = new int[n_vertex];
+		bool *visited = new bool[n_vertex]();
+		int max_deg = 0;
+
+		#pragma omp parallel for reduction(max : max_deg)
+		for (int i = 0; i < n_vertex; i++)
+		{
+			deg[i] = row[i + 1] - row[i];
+			max_deg = std::max(max_deg, deg[i]);
+		}
+		Ordering::counting_sort(deg, max_deg + 1, n_vertex, by_degree);
+
+		auto by_deg = [&](int u, int v) { return deg[u] < deg[v] || (deg[u] == deg[v] && u < v); };
+		int tail = 0;
+		for (int i = 0; i < n_vertex; i++)
+		{
+			int s = by_degree[i];
+			if (visited[s])
+				continue;
+			visited[s] = true;
+			perm[tail++] = s;
+
+			for (int head = tail - 1; head < tail; head++)
+			{
+				int v = perm[head];
+				int first = tail;
+				for (edge_t j = row[v]; j < row[v + 1]; j++)
+				{
+					if (!visited[col[j]])
+					{
+						visited[col[j]] = true;
+						perm[tail++] = col[j];
+					}
+				}
+				std::sort(perm + first, perm + tail, by_deg);
+			}
+		}
+		std::reverse(perm, perm + n_vertex);
+
+		delete[] visited;
+		delete[] by_degree;
+		delete[] deg;
+	}
+
+	/**
+	 * @brief Relabel the graph, vertex perm[i] of the input becomes vertex i of the output
+	 *
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param perm: permutation shaped (n_vertex, )
+	 * @param new_row: output row pointer, allocated with new[]
+	 * @param new_col: output column pointer, allocated with new[]
+	 */
+	inline void permute(edge_t *row, vertex_t *col, vertex_t n_vertex, int perm[], edge_t **new_row, vertex_t **new_col)
+	{
+		int *inv = new int[n_vertex];
+		edge_t *prow = new edge_t[n_vertex + 1];
+		vertex_t *pcol = new vertex_t[row[n_vertex]];
+
+		prow[0] = 0;
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+		{
+			inv[perm[i]] = i;
+			prow[i + 1] = row[perm[i] + 1] - row[perm[i]];
+		}
+
+		for (int i = 0; i < n_vertex; i++)
+			prow[i + 1] += prow[i];
+
+		#pragma omp parallel for schedule(dynamic, 256)
+		for (int i = 0; i < n_vertex; i++)
+		{
+			edge_t k = prow[i];
+			for (edge_t j = row[perm[i]]; j < row[perm[i] + 1]; j++)
+				pcol[k++] = inv[col[j]];
+			std::sort(pcol + prow[i], pcol + prow[i + 1]);
+		}
+
+		delete[] inv;
+		*new_row = prow;
+		*new_col = pcol;
+	}
+
+	/**
+	 * @brief Map a colormap of the relabeled graph back to the input ids
+	 *
+	 * @param n_vertex: number of vertices
+	 * @param perm: permutation shaped (n_vertex, )
+	 * @param permuted: colormap of the relabeled graph
+	 * @param colormap: output colormap of the input graph
+	 */
+	inline void unpermute(vertex_t n_vertex, int perm[], int permuted[], int colormap[])
+	{
+		#pragma omp parallel for
+		for (int i = 0; i < n_vertex; i++)
+			colormap[perm[i]] = permuted[i];
+	}
+
+	/**
+	 * @brief Compute a relabeling by name
+	 *
+	 * @param name: rcm (reverse Cuthill-McKee), bfs, or degree (largest degree first)
+	 * @param row: row pointer
+	 * @param col: column pointer
+	 * @param n_vertex: number of vertices
+	 * @param perm: output permutation shaped (n_vertex, )
+	 * @return false if the name is unknown
+	 */
+	inline bool compute(const std::string &name, edge_t *row, vertex_t *col, vertex_t n_vertex, int perm[])
+	{
+		if (name == "rcm")
+			rcm(row, col, n_vertex, perm);
+		else if (name == "bfs")
+			bfs(row, col, n_vertex, perm);
+		else if (name == "degree")
+			Ordering::largest_first(row, n_vertex, perm);
+		else
+			return false;
+		return true;
+	}
+}
+
+#endif
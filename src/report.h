@@ -0,0 +1,218 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "utils/graph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Timings and counters of one phase of a coloring run, aggregated over threads
+ *
+ * @param name Phase name, color, detect or recolor
+ * @param round Round the phase belongs to
+ * @param t_wall Wall time from the first thread entering to the last one leaving
+ * @param n_vertex Vertices colored or checked
+ * @param n_edge Edges traversed
+ * @param t_busy_max Longest time a thread spent on its share
+ * @param t_busy_mean Mean time a thread spent on its share
+ */
+typedef struct phase
+{
+	const char *name;
+	int round;
+	double t_wall;
+	long long n_vertex;
+	long long n_edge;
+	double t_busy_max;
+	double t_busy_mean;
+
+	/**
+	 * @brief Mean time a thread waited for the others
+	 */
+	inline double t_idle_mean() const { return t_wall - t_busy_mean; }
+
+	/**
+	 * @brief Load imbalance, longest share over mean share, 1 when perfectly balanced
+	 */
+	inline double imbalance() const { return t_busy_mean > 0 ? t_busy_max / t_busy_mean : 1; }
+} phase;
+
+/**
+ * @brief Report wrapper for result and performance.
+ *
+ * @param t_exec Execution time
+ * @param n_color Number of colors
+ * @param n_conflict Number of conflicts
+ * @param phases Per-phase breakdown of t_exec, in execution order
+ * @param class_imbalance Largest color class over the mean class size, 1 when perfectly balanced, NAN if not measured
+ * @param n_moved Vertices moved to another class by balancing, -1 if not balanced
+ * @param n_recolored Vertices recolored by a repair, -1 if not a repair
+ */
+typedef struct report
+{
+	double t_exec;
+	int n_color;
+	int n_conflict;
+	std::vector<phase> phases;
+	double class_imbalance = NAN;
+	int n_moved = -1;
+	int n_recolored = -1;
+} report;
+
+/**
+ * @brief Per-thread phase recorder
+ *
+ * Every thread records its own share of each phase without synchronizing, the shares are
+ * matched up by position once the parallel region is over, so every thread has to record
+ * the same sequence of phases.
+ */
+class Profile
+{
+public:
+	/**
+	 * @param n_thread: number of threads of the region the phases run in
+	 */
+	explicit Profile(int n_thread) : samples(n_thread) {}
+
+	/**
+	 * @brief Record the share of the calling thread, right after it finished it
+	 *
+	 * @param name: phase name
+	 * @param round: round the phase belongs to
+	 * @param n_vertex: vertices of the phase over all threads
+	 * @param t_start: when the thread started its share
+	 * @param n_edge: edges the thread traversed
+	 */
+	inline void record(const char *name, int round, long long n_vertex, double t_start, long long n_edge)
+	{
+		samples[omp_get_thread_num()].push_back({name, round, n_vertex, t_start, omp_get_wtime(), n_edge});
+	}
+
+	/**
+	 * @brief Aggregate the recorded phases over threads
+	 */
+	std::vector<phase> phases() const
+	{
+		std::vector<phase> out;
+		int n_thread = 0;
+		for (const auto &s : samples)
+			n_thread += !s.empty();
+		if (n_thread == 0)
+			return out;
+
+		for (size_t i = 0; i < samples[0].size(); i++)
+		{
+			const sample &first = samples[0][i];
+			phase p = {first.name, first.round, 0, first.n_vertex, 0, 0, 0};
+			double t_begin = first.t_start, t_end = first.t_stop;
+			for (const auto &s : samples)
+			{
+				if (i >= s.size())
+					continue;
+				double busy = s[i].t_stop - s[i].t_start;
+				t_begin = std::min(t_begin, s[i].t_start);
+				t_end = std::max(t_end, s[i].t_stop);
+				p.n_edge += s[i].n_edge;
+				p.t_busy_max = std::max(p.t_busy_max, busy);
+				p.t_busy_mean += busy / n_thread;
+			}
+			p.t_wall = t_end - t_begin;
+			out.push_back(p);
+		}
+		return out;
+	}
+
+private:
+	struct sample
+	{
+		const char *name;
+		int round;
+		long long n_vertex;
+		double t_start, t_stop;
+		long long n_edge;
+	};
+	std::vector<std::vector<sample>> samples;
+};
+
+/**
+ * @brief Summary of the execution times of repeated runs of one configuration
+ *
+ * @param n_run Number of measured runs
+ * @param t_min Shortest time
+ * @param t_median Median time
+ * @param t_p95 95th percentile, nearest rank
+ * @param t_mean Mean time
+ * @param t_ci95 Half width of the 95% confidence interval of the mean, Student t, 0 for a single run
+ */
+typedef struct timing
+{
+	int n_run;
+	double t_min;
+	double t_median;
+	double t_p95;
+	double t_mean;
+	double t_ci95;
+
+	/**
+	 * @brief Summarize a non-empty set of times
+	 */
+	static timing of(std::vector<double> t)
+	{
+		// two-sided 97.5% quantiles of Student t for 1..30 degrees of freedom, normal beyond
+		static const double student[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+										 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+										 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+		int n = t.size();
+		std::sort(t.begin(), t.end());
+		timing s = {n, t[0], n % 2 ? t[n / 2] : (t[n / 2 - 1] + t[n / 2]) / 2, t[(int)std::ceil(0.95 * n) - 1], 0, 0};
+		for (double x : t)
+			s.t_mean += x / n;
+		if (n > 1)
+		{
+			double var = 0;
+			for (double x : t)
+				var += (x - s.t_mean) * (x - s.t_mean) / (n - 1);
+			s.t_ci95 = (n - 1 <= 30 ? student[n - 2] : 1.960) * std::sqrt(var / n);
+		}
+		return s;
+	}
+} timing;
+
+/**
+ * @brief Largest color class over the mean class size of a coloring
+ *
+ * @param n_vertex: number of vertices
+ * @param colormap: color array shaped (n_vertex, ), colors below n_color
+ * @param n_color: number of colors
+ */
+inline double class_imbalance(vertex_t n_vertex, const int colormap[], int n_color)
+{
+	if (n_vertex == 0 || n_color == 0)
+		return 1;
+	std::vector<vertex_t> size(n_color);
+	#pragma omp parallel
+	{
+		std::vector<vertex_t> local(n_color);
+		#pragma omp for nowait
+		for (vertex_t v = 0; v < n_vertex; v++)
+			local[colormap[v]]++;
+		#pragma omp critical
+		for (int c = 0; c < n_color; c++)
+			size[c] += local[c];
+	}
+	return (double)*std::max_element(size.begin(), size.end()) * n_color / n_vertex;
+}
+
+inline int max(vertex_t len, int colormap[])
+{
+	int val = -1;
+	for (int i = 0; i < len; i++)
+		if (colormap[i] > val)
+			val = colormap[i];
+	return val + 1;
+}
+
+#endif
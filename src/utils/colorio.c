@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "colorio.h"
+
+int color_classes(const int * colormap, vertex_t n_vertex, int n_color,
+	vertex_t * class_ptr, vertex_t * class_vid) {
+
+	int n_thread = omp_get_max_threads();
+	int bad = 0;
+	// one histogram per thread over its block of vertices, n_color is small next to n_vertex
+	vertex_t * count = (vertex_t * ) calloc((size_t) n_thread * n_color + 1, sizeof(vertex_t));
+	if (count == NULL)
+		return -1;
+
+	#pragma omp parallel num_threads(n_thread)
+	{
+		int t = omp_get_thread_num(), nt = omp_get_num_threads();
+		vertex_t begin = (vertex_t)((long long) n_vertex * t / nt);
+		vertex_t end = (vertex_t)((long long) n_vertex * (t + 1) / nt);
+		vertex_t * c = count + (size_t) t * n_color;
+
+		for (vertex_t v = begin; v < end; v++) {
+			int k = colormap[v];
+			if (k < 0 || k >= n_color) {
+				#pragma omp atomic write
+				bad = 1;
+				break;
+			}
+			c[k]++;
+		}
+		#pragma omp barrier
+
+		// offsets in (color, thread) order, so every block lands in place and classes stay sorted
+		#pragma omp single
+		{
+			vertex_t offset = 0;
+			for (int k = 0; k < n_color; k++) {
+				class_ptr[k] = offset;
+				for (int i = 0; i < nt; i++) {
+					vertex_t n = count[(size_t) i * n_color + k];
+					count[(size_t) i * n_color + k] = offset;
+					offset += n;
+				}
+			}
+			class_ptr[n_color] = offset;
+		}
+
+		if (!bad)
+			for (vertex_t v = begin; v < end; v++)
+				class_vid[c[colormap[v]]++] = v;
+	}
+
+	free(count);
+	return bad ? -1 : 0;
+}
+
+static int write_section(FILE * bp, uint64_t offset, const void * data, size_t size) {
+	static const char zeros[COLORING_ALIGN] = {0};
+	long pos = ftell(bp);
+
+	if (pos < 0 || (uint64_t) pos > offset)
+		return -1;
+	if (fwrite(zeros, 1, (size_t)(offset - pos), bp) != (size_t)(offset - pos))
+		return -1;
+	if (size > 0 && fwrite(data, 1, size, bp) != size)
+		return -1;
+	return 0;
+}
+
+static uint64_t align_up(uint64_t x) {
+	return (x + COLORING_ALIGN - 1) / COLORING_ALIGN * COLORING_ALIGN;
+}
+
+static void coloring_layout(ColoringHeader * h, vertex_t n_vertex, int n_color) {
+	memset(h, 0, sizeof(ColoringHeader));
+	memcpy(h -> magic, COLORING_MAGIC, 8);
+	h -> version = COLORING_VERSION;
+	h -> color_size = sizeof(int);
+	h -> vertex_size = sizeof(vertex_t);
+	h -> n_vertex = n_vertex;
+	h -> n_color = n_color;
+	h -> off_colormap = COLORING_ALIGN;
+	h -> off_class_ptr = align_up(h -> off_colormap + sizeof(int) * n_vertex);
+	h -> off_class_vid = align_up(h -> off_class_ptr + sizeof(vertex_t) * ((uint64_t) n_color + 1));
+	h -> file_size = h -> off_class_vid + sizeof(vertex_t) * n_vertex;
+}
+
+int write_coloring(const char * path, const int * colormap, vertex_t n_vertex) {
+	char tpath[1100];
+	ColoringHeader h;
+	vertex_t * class_ptr, * class_vid;
+	FILE * bp;
+	int n_color = 0, status = -1;
+
+	#pragma omp parallel for reduction(max : n_color)
+	for (vertex_t v = 0; v < n_vertex; v++)
+		if (colormap[v] + 1 > n_color)
+			n_color = colormap[v] + 1;
+
+	class_ptr = (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) n_color + 1));
+	class_vid = (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) n_vertex + 1));
+	if (class_ptr != NULL && class_vid != NULL &&
+		color_classes(colormap, n_vertex, n_color, class_ptr, class_vid) == 0) {
+
+		coloring_layout( & h, n_vertex, n_color);
+		snprintf(tpath, sizeof(tpath), "%s.%ld.tmp", path, (long) getpid());
+		bp = fopen(tpath, "wb");
+		if (bp != NULL) {
+			status = write_section(bp, 0, & h, sizeof(ColoringHeader)) != 0 ||
+				write_section(bp, h.off_colormap, colormap, sizeof(int) * n_vertex) != 0 ||
+				write_section(bp, h.off_class_ptr, class_ptr, sizeof(vertex_t) * ((size_t) n_color + 1)) != 0 ||
+				write_section(bp, h.off_class_vid, class_vid, sizeof(vertex_t) * n_vertex) != 0 ? -1 : 0;
+			if (fclose(bp) != 0 || status == -1 || rename(tpath, path) != 0) {
+				status = -1;
+				remove(tpath);
+			}
+		}
+	}
+
+	free(class_ptr);
+	free(class_vid);
+	return status;
+}
+
+int read_coloring(const char * path, int ** colormap, vertex_t ** class_ptr,
+	vertex_t ** class_vid, vertex_t * n_vertex, int * n_color) {
+
+	struct stat st;
+	ColoringHeader h, expect;
+	char * base;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, & st) != 0 || (size_t) st.st_size < sizeof(ColoringHeader) ||
+		pread(fd, & h, sizeof(ColoringHeader), 0) != (ssize_t) sizeof(ColoringHeader)) {
+		close(fd);
+		return -1;
+	}
+
+	// the layout is fully determined by the counts, so compare against a fresh one
+	coloring_layout( & expect, (vertex_t) h.n_vertex, (int) h.n_color);
+	if (memcmp( & h, & expect, sizeof(ColoringHeader)) != 0 || (uint64_t) st.st_size < h.file_size) {
+		close(fd);
+		return -1;
+	}
+
+	base = (char * ) mmap(NULL, h.file_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return -1;
+
+	* n_vertex = (vertex_t) h.n_vertex;
+	* n_color = (int) h.n_color;
+	* colormap = (int * )(base + h.off_colormap);
+	* class_ptr = (vertex_t * )(base + h.off_class_ptr);
+	* class_vid = (vertex_t * )(base + h.off_class_vid);
+	return 0;
+}
+
+void free_coloring(int * colormap) {
+	// the colormap is the first section, the header sits right before it
+	char * base = (char * ) colormap - COLORING_ALIGN;
+	munmap(base, ((ColoringHeader * ) base) -> file_size);
+}
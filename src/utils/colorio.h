@@ -0,0 +1,59 @@
+#include <stdint.h>
+#include "graph.h"
+
+#ifndef COLORIO_H
+#define COLORIO_H
+
+/*
+ * Coloring file, for consumers that process a graph one color class at a time.
+ * It holds the colormap and the color classes as a CSR, class c being the
+ * vertices class_vid[class_ptr[c] .. class_ptr[c + 1]) in increasing order.
+ *
+ * Layout, version 1, in native byte order:
+ * a ColoringHeader padded to COLORING_ALIGN bytes, followed by colormap
+ * (int, n_vertex), class_ptr (vertex_t, n_color + 1) and class_vid (vertex_t,
+ * n_vertex), each starting at a multiple of COLORING_ALIGN, so a consumer maps
+ * the file and uses the arrays in place.
+ */
+#define COLORING_MAGIC "COLORMAP"
+#define COLORING_VERSION 1
+#define COLORING_ALIGN 4096
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	// sizes of a color and of vertex_t at write time
+	uint32_t color_size, vertex_size;
+	uint32_t reserved;
+	uint64_t n_vertex, n_color;
+	uint64_t off_colormap, off_class_ptr, off_class_vid;
+	uint64_t file_size;
+}
+ColoringHeader;
+
+/*
+ * Bucket the vertices by color with a parallel counting sort, class_ptr holds
+ * n_color + 1 offsets and class_vid n_vertex vertices. Returns -1 if a vertex
+ * is uncolored or has a color of n_color or more, or out of memory.
+ */
+int color_classes(const int * colormap, vertex_t n_vertex, int n_color,
+	vertex_t * class_ptr, vertex_t * class_vid);
+
+/*
+ * Write colormap and its color classes to path, written aside and renamed so a
+ * reader never maps a partial file. Colors are 0 .. n_color - 1, n_color being
+ * one more than the largest color. Returns -1 on an invalid coloring or I/O error.
+ */
+int write_coloring(const char * path, const int * colormap, vertex_t n_vertex);
+
+/*
+ * Map a coloring file read-only and point into it, the arrays must not be
+ * written to. Returns -1 if the file is not a coloring of this version and
+ * these index types. Release with free_coloring.
+ */
+int read_coloring(const char * path, int ** colormap, vertex_t ** class_ptr,
+	vertex_t ** class_vid, vertex_t * n_vertex, int * n_color);
+
+void free_coloring(int * colormap);
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef COLORSET_H
+#define COLORSET_H
+
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Forbidden color set used by firstfit
+ *
+ * A bitset over colors [0, capacity). Every 64-bit word carries a generation
+ * stamp and only counts as set when its stamp matches the current generation,
+ * so clear() is O(1) and never touches the words themselves.
+ * Colors >= capacity are ignored, which is safe as long as capacity exceeds
+ * the number of colored neighbors of any vertex.
+ */
+class ColorSet
+{
+public:
+	/**
+	 * @param capacity: number of colors tracked, rounded up to a multiple of 256
+	 */
+	explicit ColorSet(int capacity)
+	{
+		n_word = ((capacity + 255) / 256) * 4;
+		bits = new uint64_t[n_word]();
+		stamp = new uint64_t[n_word]();
+		gen = 1;
+	}
+
+	~ColorSet()
+	{
+		delete[] bits;
+		delete[] stamp;
+	}
+
+	ColorSet(const ColorSet &) = delete;
+	ColorSet &operator=(const ColorSet &) = delete;
+
+	inline void clear() { ++gen; }
+
+	inline void insert(int c)
+	{
+		int w = c >> 6;
+		if (w >= n_word)
+			return;
+		if (stamp[w] != gen)
+		{
+			stamp[w] = gen;
+			bits[w] = 0;
+		}
+		bits[w] |= 1ull << (c & 63);
+	}
+
+	inline bool contains(int c) const
+	{
+		int w = c >> 6;
+		return w < n_word && stamp[w] == gen && (bits[w] >> (c & 63) & 1);
+	}
+
+	/**
+	 * @brief Smallest color not in the set, -1 if all tracked colors are used
+	 */
+	inline int first_free() const
+	{
+		int w = 0;
+#if defined(__AVX2__)
+		const __m256i g = _mm256_set1_epi64x((long long)gen);
+		const __m256i ones = _mm256_set1_epi64x(-1);
+		for (; w < n_word; w += 4)
+		{
+			__m256i b = _mm256_loadu_si256((const __m256i *)(bits + w));
+			__m256i s = _mm256_loadu_si256((const __m256i *)(stamp + w));
+			b = _mm256_and_si256(b, _mm256_cmpeq_epi64(s, g));
+			int full = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(b, ones)));
+			if (full != 0xF)
+				break;
+		}
+#elif defined(__SSE4_1__)
+		const __m128i g = _mm_set1_epi64x((long long)gen);
+		const __m128i ones = _mm_set1_epi64x(-1);
+		for (; w < n_word; w += 2)
+		{
+			__m128i b = _mm_loadu_si128((const __m128i *)(bits + w));
+			__m128i s = _mm_loadu_si128((const __m128i *)(stamp + w));
+			b = _mm_and_si128(b, _mm_cmpeq_epi64(s, g));
+			int full = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(b, ones)));
+			if (full != 0x3)
+				break;
+		}
+#endif
+		// finish within the block found above, or do the whole scan without SIMD
+		for (; w < n_word; w++)
+		{
+			uint64_t word = stamp[w] == gen ? bits[w] : 0;
+			if (~word)
+				return (w << 6) + __builtin_ctzll(~word);
+		}
+		return -1;
+	}
+
+private:
+	int n_word;
+	uint64_t *bits;
+	uint64_t *stamp;
+	uint64_t gen;
+};
+
+#endif
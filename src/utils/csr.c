@@ -0,0 +1,355 @@
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "csr.h"
+
+// entries scattered per batch by build_csr, two positions each when mirrored, kept on the stack
+#define SCATTER_BATCH 256
+// shortest shift of a block of rows merge_rows moves with all threads, shorter ones are one memmove
+#define MERGE_WINDOW 4096
+
+int coo_push(Coo * c, vertex_t u, vertex_t v, eweight_t w) {
+	if (c -> n == c -> cap) {
+		edge_t cap = c -> cap ? 2 * c -> cap : 4096;
+		vertex_t * nu = (vertex_t * ) realloc(c -> u, sizeof(vertex_t) * cap);
+		vertex_t * nv = (vertex_t * ) realloc(c -> v, sizeof(vertex_t) * cap);
+		eweight_t * nw = c -> weighted ? (eweight_t * ) realloc(c -> w, sizeof(eweight_t) * cap) : NULL;
+		if (nu) c -> u = nu;
+		if (nv) c -> v = nv;
+		if (nw) c -> w = nw;
+		if (!nu || !nv || (c -> weighted && !nw))
+			return -1;
+		c -> cap = cap;
+	}
+	c -> u[c -> n] = u;
+	c -> v[c -> n] = v;
+	if (c -> weighted)
+		c -> w[c -> n] = w;
+	c -> n++;
+	return 0;
+}
+
+void coo_free(Coo * c) {
+	free(c -> u);
+	free(c -> v);
+	free(c -> w);
+	c -> u = c -> v = NULL;
+	c -> w = NULL;
+	c -> n = c -> cap = 0;
+}
+
+static void swap_entry(vertex_t * a, eweight_t * w, edge_t i, edge_t j) {
+	vertex_t t = a[i];
+	a[i] = a[j];
+	a[j] = t;
+	if (w) {
+		eweight_t s = w[i];
+		w[i] = w[j];
+		w[j] = s;
+	}
+}
+
+/* sort a row by column, carrying the weights along when there are any */
+static void sort_row(vertex_t * a, eweight_t * w, edge_t n) {
+	while (n > 16) {
+		// median of three, then Hoare partition
+		edge_t m = n / 2, i = 0, j = n - 1;
+		vertex_t pivot;
+		if (a[m] < a[0]) swap_entry(a, w, m, 0);
+		if (a[n - 1] < a[0]) swap_entry(a, w, n - 1, 0);
+		if (a[n - 1] < a[m]) swap_entry(a, w, n - 1, m);
+		pivot = a[m];
+
+		for (;;) {
+			while (a[i] < pivot) i++;
+			while (a[j] > pivot) j--;
+			if (i >= j)
+				break;
+			swap_entry(a, w, i++, j--);
+		}
+
+		// recurse into the smaller side, loop on the larger one
+		if (j + 1 < n - j - 1) {
+			sort_row(a, w, j + 1);
+			a += j + 1;
+			if (w) w += j + 1;
+			n -= j + 1;
+		} else {
+			sort_row(a + j + 1, w ? w + j + 1 : NULL, n - j - 1);
+			n = j + 1;
+		}
+	}
+
+	for (edge_t i = 1; i < n; i++)
+		for (edge_t j = i; j > 0 && a[j] < a[j - 1]; j--)
+			swap_entry(a, w, j, j - 1);
+}
+
+/* part and index within it of entry e, the parts laid end to end from part_start, e below the total */
+static void locate(const edge_t * part_start, edge_t e, int * p, edge_t * i) {
+	int q = 0;
+	while (part_start[q + 1] <= e)
+		q++;
+	* p = q;
+	* i = e - part_start[q];
+}
+
+/* the entry after (p, i), skipping empty parts, part_start ends with a part of one entry to stop at */
+static void advance(const edge_t * part_start, int * p, edge_t * i) {
+	if (++( * i) == part_start[ * p + 1] - part_start[ * p]) {
+		* i = 0;
+		do
+			( * p)++;
+		while (part_start[ * p + 1] == part_start[ * p]);
+	}
+}
+
+int merge_rows(vertex_t n_vertex, edge_t * xadj, vertex_t ** adj, eweight_t ** ew) {
+	vertex_t * a = * adj;
+	eweight_t * w = ew ? * ew : NULL;
+	edge_t nnz = xadj[n_vertex];
+	int n_block = omp_get_max_threads();
+	edge_t * len = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n_vertex + 1));
+	edge_t * kept = (edge_t * ) calloc((size_t) n_block + 1, sizeof(edge_t));
+	vertex_t * first = (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) n_block + 1));
+
+	if (!len || !kept || !first) {
+		free(len);
+		free(kept);
+		free(first);
+		return -1;
+	}
+
+	// sort every row and merge its duplicates to the front, its merged length goes to len[r]
+	#pragma omp parallel for schedule(dynamic, 256)
+	for (vertex_t r = 0; r < n_vertex; r++) {
+		edge_t l = xadj[r], h = xadj[r + 1], k = l;
+		sort_row(a + l, w ? w + l : NULL, h - l);
+		for (edge_t j = l; j < h; j++) {
+			if (j == l || a[j] != a[k - 1]) {
+				a[k] = a[j];
+				if (w) w[k] = w[j];
+				k++;
+			} else if (w) {
+				w[k - 1] += w[j];
+			}
+		}
+		len[r] = k - l;
+	}
+
+	// blocks of rows holding about as many entries each, the first row of a block is the
+	// first one starting at or past its share
+	for (int b = 0; b <= n_block; b++) {
+		edge_t target = (edge_t)((double) nnz * b / n_block);
+		vertex_t lo = b ? first[b - 1] : 0, hi = n_vertex;
+		while (lo < hi) {
+			vertex_t mid = lo + (hi - lo) / 2;
+			if (xadj[mid] < target)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		first[b] = b == n_block ? n_vertex : lo;
+	}
+
+	// rows only move left, so every block squeezes its rows to the front of its own entries
+	#pragma omp parallel for schedule(static, 1)
+	for (int b = 0; b < n_block; b++) {
+		edge_t to = xadj[first[b]];
+		for (vertex_t r = first[b]; r < first[b + 1]; r++) {
+			if (to != xadj[r]) {
+				memmove(a + to, a + xadj[r], sizeof(vertex_t) * len[r]);
+				if (w)
+					memmove(w + to, w + xadj[r], sizeof(eweight_t) * len[r]);
+			}
+			to += len[r];
+		}
+		kept[b + 1] = to - xadj[first[b]];
+	}
+	for (int b = 0; b < n_block; b++)
+		kept[b + 1] += kept[b];
+
+	// then the blocks close up in block order, since a block may land on the one before. The threads
+	// share a block in windows no longer than its shift, so none overwrites what another has yet to read
+	if (kept[n_block] != nnz) {
+		#pragma omp parallel
+		for (int b = 0; b < n_block; b++) {
+			edge_t from = xadj[first[b]], n = kept[b + 1] - kept[b], shift = from - kept[b];
+			if (shift == 0 || n == 0)
+				continue;
+			if (shift < MERGE_WINDOW) {
+				#pragma omp single
+				{
+					memmove(a + kept[b], a + from, sizeof(vertex_t) * n);
+					if (w)
+						memmove(w + kept[b], w + from, sizeof(eweight_t) * n);
+				}
+				continue;
+			}
+			for (edge_t j0 = 0; j0 < n; j0 += shift) {
+				edge_t j1 = j0 + shift < n ? j0 + shift : n;
+				#pragma omp for schedule(static)
+				for (edge_t j = j0; j < j1; j++) {
+					a[kept[b] + j] = a[from + j];
+					if (w)
+						w[kept[b] + j] = w[from + j];
+				}
+			}
+		}
+	}
+
+	// row offsets, a prefix sum of the merged lengths from the offset of each block
+	#pragma omp parallel for schedule(static, 1)
+	for (int b = 0; b < n_block; b++) {
+		edge_t offset = kept[b];
+		for (vertex_t r = first[b]; r < first[b + 1]; r++) {
+			xadj[r] = offset;
+			offset += len[r];
+		}
+	}
+	xadj[n_vertex] = kept[n_block];
+
+	if (kept[n_block] != nnz) {
+		nnz = kept[n_block];
+		vertex_t * na = (vertex_t * ) realloc(a, sizeof(vertex_t) * ((size_t) nnz + 1));
+		if (na) * adj = na;
+		if (w) {
+			eweight_t * nw = (eweight_t * ) realloc(w, sizeof(eweight_t) * ((size_t) nnz + 1));
+			if (nw) * ew = nw;
+		}
+	}
+
+	free(len);
+	free(kept);
+	free(first);
+	return 0;
+}
+
+int build_csr(Coo * part, int n_part, vertex_t n_vertex, int flags,
+	edge_t ** xadj, vertex_t ** adj, eweight_t ** ew) {
+
+	int symmetric = flags & CSR_SYMMETRIC;
+	int n_thread = omp_get_max_threads();
+	edge_t * start = (edge_t * ) calloc((size_t) n_vertex + 1, sizeof(edge_t));
+	edge_t * fill = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n_vertex + 1));
+	edge_t * part_start = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n_part + 2));
+	vertex_t * a = NULL;
+	eweight_t * w = NULL;
+	edge_t nnz, n_entry;
+
+	if (!start || !fill || !part_start) {
+		free(start);
+		free(fill);
+		free(part_start);
+		return -1;
+	}
+
+	// the entries are split evenly over the threads whatever parts the reader filled, an
+	// empty sentinel part keeps advance from running past the last one
+	part_start[0] = 0;
+	for (int p = 0; p < n_part; p++)
+		part_start[p + 1] = part_start[p] + part[p].n;
+	part_start[n_part + 1] = part_start[n_part] + 1;
+	n_entry = part_start[n_part];
+
+	// degree histogram, mirrored entries included
+	#pragma omp parallel num_threads(n_thread)
+	{
+		int t = omp_get_thread_num(), nt = omp_get_num_threads();
+		edge_t lo = (edge_t)((double) n_entry * t / nt), hi = (edge_t)((double) n_entry * (t + 1) / nt);
+		int p;
+		edge_t i;
+		if (lo < hi) {
+			locate(part_start, lo, & p, & i);
+			for (edge_t e = lo; e < hi; e++, advance(part_start, & p, & i)) {
+				vertex_t u = part[p].u[i], v = part[p].v[i];
+				#pragma omp atomic
+				start[u + 1]++;
+				if (symmetric && u != v) {
+					#pragma omp atomic
+					start[v + 1]++;
+				}
+			}
+		}
+	}
+
+	for (vertex_t r = 0; r < n_vertex; r++)
+		start[r + 1] += start[r];
+	nnz = start[n_vertex];
+	memcpy(fill, start, sizeof(edge_t) * ((size_t) n_vertex + 1));
+
+	a = (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) nnz + 1));
+	if (ew)
+		w = (eweight_t * ) malloc(sizeof(eweight_t) * ((size_t) nnz + 1));
+	if (!a || (ew && !w)) {
+		free(start);
+		free(fill);
+		free(part_start);
+		free(a);
+		free(w);
+		return -1;
+	}
+
+	// scatter straight into the unmerged rows, over the same ranges.
+	// Positions are reserved a batch at a time before the entries are written, a locked
+	// add waits for the stores before it, which would otherwise serialize their misses.
+	#pragma omp parallel num_threads(n_thread)
+	{
+		int t = omp_get_thread_num(), nt = omp_get_num_threads();
+		edge_t lo = (edge_t)((double) n_entry * t / nt), hi = (edge_t)((double) n_entry * (t + 1) / nt);
+		edge_t pos[2 * SCATTER_BATCH];
+		int p = 0;
+		edge_t i = 0;
+		if (lo < hi)
+			locate(part_start, lo, & p, & i);
+		for (edge_t e0 = lo; e0 < hi; e0 += SCATTER_BATCH) {
+			edge_t e1 = e0 + SCATTER_BATCH < hi ? e0 + SCATTER_BATCH : hi;
+			int p0 = p;
+			edge_t i0 = i;
+			int k = 0;
+			for (edge_t e = e0; e < e1; e++, advance(part_start, & p, & i)) {
+				vertex_t u = part[p].u[i], v = part[p].v[i];
+				#pragma omp atomic capture
+				pos[k] = fill[u]++;
+				k++;
+				if (symmetric && u != v) {
+					#pragma omp atomic capture
+					pos[k] = fill[v]++;
+					k++;
+				}
+			}
+
+			p = p0;
+			i = i0;
+			k = 0;
+			for (edge_t e = e0; e < e1; e++, advance(part_start, & p, & i)) {
+				vertex_t u = part[p].u[i], v = part[p].v[i];
+				a[pos[k]] = v;
+				if (w) w[pos[k]] = part[p].w[i];
+				k++;
+				if (symmetric && u != v) {
+					a[pos[k]] = u;
+					if (w) w[pos[k]] = part[p].w[i];
+					k++;
+				}
+			}
+		}
+	}
+	for (int p = 0; p < n_part; p++)
+		coo_free( & part[p]);
+	free(part_start);
+	free(fill);
+
+	if (merge_rows(n_vertex, start, & a, w ? & w : NULL) != 0) {
+		free(start);
+		free(a);
+		free(w);
+		return -1;
+	}
+
+	( * xadj) = start;
+	( * adj) = a;
+	if (ew)
+		( * ew) = w;
+	return 0;
+}
@@ -0,0 +1,46 @@
+#include "graph.h"
+
+#ifndef CSR_H
+#define CSR_H
+
+/* coordinate buffer, filled by one parsing thread, w is only kept when weighted */
+typedef struct {
+	vertex_t * u;
+	vertex_t * v;
+	eweight_t * w;
+	edge_t n;
+	edge_t cap;
+	int weighted;
+}
+Coo;
+
+/* build_csr flags */
+#define CSR_SYMMETRIC 0x1 /* an entry (u, v) with u != v also stands for (v, u) */
+
+int coo_push(Coo * c, vertex_t u, vertex_t v, eweight_t w);
+
+void coo_free(Coo * c);
+
+/*
+ * Sort the rows of a CSR and merge their duplicate entries in place, summing
+ * their weights, xadj is updated and adj and ew are shrunk to fit. Rows are
+ * compacted in parallel, each thread closing up a block of rows from a prefix
+ * sum of the merged row lengths. Pass ew NULL when there are no weights.
+ * Returns -1 out of memory, leaving the rows as given.
+ */
+int merge_rows(vertex_t n_vertex, edge_t * xadj, vertex_t ** adj, eweight_t ** ew);
+
+/*
+ * Build CSR from coordinate buffers by a parallel counting sort, rows are 0-based.
+ * Rows come out sorted, duplicate entries are merged and their weights summed.
+ * The entries are split evenly over the threads however many buffers there
+ * are, a single one included. The buffers are released once scattered, so peak
+ * memory is one copy of the entries plus the unmerged CSR. Entries are scattered
+ * SCATTER_BATCH at a time, their row positions reserved with atomics first and
+ * written after, so the cache misses of the writes overlap. Pass ew NULL to
+ * skip weights, it must be NULL unless the buffers are weighted.
+ */
+int build_csr(Coo * part, int n_part, vertex_t n_vertex, int flags,
+	edge_t ** xadj, vertex_t ** adj, eweight_t ** ew);
+
+#endif
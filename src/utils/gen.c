@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <limits.h>
+#include <omp.h>
+#include "csr.h"
+#include "gen.h"
+
+// edges generated per batch by the R-MAT fill, kept on the stack
+#define RMAT_BATCH 256
+
+/* splitmix64 finalizer, every generated value is a pure function of the seed and an index */
+static uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/* uniform in [0, 1) */
+static double uniform(uint64_t x) {
+	return (double)(mix(x) >> 11) / 9007199254740992.0;
+}
+
+/* prefix sum of the row sizes in xadj[1..n], fails if the total does not fit edge_t */
+static int row_offsets(edge_t * xadj, vertex_t n) {
+	uint64_t total = 0;
+	xadj[0] = 0;
+	for (vertex_t v = 0; v < n; v++) {
+		total += xadj[v + 1];
+		if (total > (uint64_t)(edge_t) -1)
+			return -1;
+		xadj[v + 1] = (edge_t) total;
+	}
+	return 0;
+}
+
+/* bijection of [0, 2^scale), so the hubs of R-MAT do not all sit at the low ids */
+static vertex_t scramble(uint64_t v, int scale, uint64_t seed) {
+	uint64_t mask = ((uint64_t) 1 << scale) - 1;
+	int shift = (scale + 1) / 2;
+	v = (v * (mix(seed) | 1)) & mask;
+	v ^= v >> shift;
+	v = (v * (mix(seed + 1) | 1)) & mask;
+	v ^= v >> shift;
+	return (vertex_t) v;
+}
+
+/* endpoints of the i-th R-MAT edge, a pure function of seed and i */
+static void rmat_edge(uint64_t i, int scale, uint64_t seed, uint64_t * u, uint64_t * v) {
+	// cumulative quadrant probabilities 0.57, 0.76 and 0.95 out of 2^32
+	const uint32_t a = 2448131358U, ab = 3264175144U, abc = 4080218931U;
+	// one quadrant per level from 32 random bits, drawn from a stream of its own per edge,
+	// without branches since the quadrants are unpredictable
+	uint64_t s = mix(seed ^ mix(i)), bits = 0;
+	* u = * v = 0;
+	for (int l = 0; l < scale; l++) {
+		if (l % 2 == 0)
+			bits = mix(s += 0x9e3779b97f4a7c15ULL);
+		uint32_t r = (uint32_t)(bits >> 32 * (l % 2));
+		* u = * u << 1 | (r >= ab);
+		* v = * v << 1 | ((r >= a) ^ (r >= ab) ^ (r >= abc));
+	}
+	* u = scramble( * u, scale, seed);
+	* v = scramble( * v, scale, seed);
+}
+
+/* the generated edges i0 .. i1 that are not self loops, returns their number */
+static int rmat_batch(uint64_t i0, uint64_t i1, int scale, uint64_t seed, vertex_t * eu, vertex_t * ev) {
+	int m = 0;
+	for (uint64_t i = i0; i < i1; i++) {
+		uint64_t u, v;
+		rmat_edge(i, scale, seed, & u, & v);
+		eu[m] = (vertex_t) u;
+		ev[m] = (vertex_t) v;
+		m += u != v;
+	}
+	return m;
+}
+
+static int gen_rmat(int scale, long long edge_factor, uint64_t seed,
+	edge_t ** xadj, vertex_t ** adj, vertex_t * n_vertex) {
+
+	uint64_t n_edge;
+	vertex_t n;
+	edge_t * x, * fill;
+	vertex_t * a;
+
+	if (scale < 1 || scale > 30 || edge_factor < 1 || edge_factor > (1LL << 32))
+		return -1;
+	n_edge = (uint64_t) edge_factor << scale;
+	// every edge is stored in both directions
+	if (2 * n_edge > (uint64_t)(edge_t) -1)
+		return -1;
+	n = (vertex_t) 1 << scale;
+
+	// edges are generated twice rather than buffered, once to count the rows and once to fill
+	// them, so like the other generators the peak memory is the CSR, with duplicates until merged
+	x = (edge_t * ) calloc((size_t) n + 1, sizeof(edge_t));
+	if (!x)
+		return -1;
+	// a batch is generated before any of its atomics, which would stall the generation otherwise
+	#pragma omp parallel for schedule(static)
+	for (uint64_t i0 = 0; i0 < n_edge; i0 += RMAT_BATCH) {
+		vertex_t eu[RMAT_BATCH], ev[RMAT_BATCH];
+		int m = rmat_batch(i0, i0 + RMAT_BATCH < n_edge ? i0 + RMAT_BATCH : n_edge, scale, seed, eu, ev);
+		for (int k = 0; k < m; k++) {
+			#pragma omp atomic
+			x[eu[k] + 1]++;
+			#pragma omp atomic
+			x[ev[k] + 1]++;
+		}
+	}
+
+	fill = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n + 1));
+	a = row_offsets(x, n) == 0 ? (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) x[n] + 1)) : NULL;
+	if (!fill || !a) {
+		free(x);
+		free(fill);
+		free(a);
+		return -1;
+	}
+	memcpy(fill, x, sizeof(edge_t) * ((size_t) n + 1));
+
+	// the same batches again, positions reserved before the entries are written, as build_csr does
+	#pragma omp parallel for schedule(static)
+	for (uint64_t i0 = 0; i0 < n_edge; i0 += RMAT_BATCH) {
+		vertex_t eu[RMAT_BATCH], ev[RMAT_BATCH];
+		edge_t pos[2 * RMAT_BATCH];
+		int m = rmat_batch(i0, i0 + RMAT_BATCH < n_edge ? i0 + RMAT_BATCH : n_edge, scale, seed, eu, ev);
+		for (int k = 0; k < m; k++) {
+			#pragma omp atomic capture
+			pos[2 * k] = fill[eu[k]]++;
+			#pragma omp atomic capture
+			pos[2 * k + 1] = fill[ev[k]]++;
+		}
+		for (int k = 0; k < m; k++) {
+			a[pos[2 * k]] = ev[k];
+			a[pos[2 * k + 1]] = eu[k];
+		}
+	}
+	free(fill);
+
+	// the scatter order depends on the threads, sorted rows do not
+	if (merge_rows(n, x, & a, NULL) != 0) {
+		free(x);
+		free(a);
+		return -1;
+	}
+	* xadj = x;
+	* adj = a;
+	* n_vertex = n;
+	return 0;
+}
+
+/* neighbors of v in the stencil in increasing order, written to out unless it is NULL, returns their number */
+static edge_t grid_row(vertex_t v, long long nx, long long ny, long long nz, int full, vertex_t * out) {
+	long long x = v % nx, y = v / nx % ny, z = v / (nx * ny);
+	edge_t n = 0;
+	for (int dz = -1; dz <= 1; dz++)
+		for (int dy = -1; dy <= 1; dy++)
+			for (int dx = -1; dx <= 1; dx++) {
+				int manhattan = abs(dx) + abs(dy) + abs(dz);
+				if (manhattan == 0 || (!full && manhattan != 1))
+					continue;
+				if (x + dx < 0 || x + dx >= nx || y + dy < 0 || y + dy >= ny || z + dz < 0 || z + dz >= nz)
+					continue;
+				if (out)
+					out[n] = (vertex_t)(x + dx + nx * (y + dy + ny * (z + dz)));
+				n++;
+			}
+	return n;
+}
+
+static int gen_grid(long long nx, long long ny, long long nz, int full,
+	edge_t ** xadj, vertex_t ** adj, vertex_t * n_vertex) {
+
+	vertex_t n;
+	edge_t * x;
+	vertex_t * a;
+
+	if (nx < 1 || ny < 1 || nz < 1 || nx > INT_MAX / ny || nx * ny > INT_MAX / nz)
+		return -1;
+	n = (vertex_t)(nx * ny * nz);
+
+	x = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n + 1));
+	if (!x)
+		return -1;
+	#pragma omp parallel for schedule(static)
+	for (vertex_t v = 0; v < n; v++)
+		x[v + 1] = grid_row(v, nx, ny, nz, full, NULL);
+
+	a = row_offsets(x, n) == 0 ? (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) x[n] + 1)) : NULL;
+	if (!a) {
+		free(x);
+		return -1;
+	}
+	#pragma omp parallel for schedule(static)
+	for (vertex_t v = 0; v < n; v++)
+		grid_row(v, nx, ny, nz, full, a + x[v]);
+
+	* xadj = x;
+	* adj = a;
+	* n_vertex = n;
+	return 0;
+}
+
+static int cmp_vertex(const void * a, const void * b) {
+	vertex_t x = * (const vertex_t * ) a, y = * (const vertex_t * ) b;
+	return (x > y) - (x < y);
+}
+
+/* points of the geometric graph, relabeled in cell order, and the cells they fall in */
+typedef struct {
+	double * x, * y;
+	vertex_t * start;
+	int g;
+	double r2;
+}
+Cells;
+
+/* coordinate of point i on axis 0 (x) or 1 (y), seed mixed over the index so seeds give other points, not a relabeling */
+static double point_coord(uint64_t seed, uint64_t i, int axis) {
+	return uniform(mix(seed ^ mix(2 * i + axis)));
+}
+
+static int cell_of(double x, int g) {
+	int c = (int)(x * g);
+	return c < g ? c : g - 1;
+}
+
+/* neighbors of v within the radius in increasing order, written to out unless it is NULL, returns their number */
+static edge_t rgg_row(const Cells * c, vertex_t v, vertex_t * out) {
+	int cx = cell_of(c -> x[v], c -> g), cy = cell_of(c -> y[v], c -> g);
+	edge_t n = 0;
+	// ids grow with the cell index, and the cells are scanned in that order
+	for (int j = cy - 1; j <= cy + 1; j++) {
+		if (j < 0 || j >= c -> g)
+			continue;
+		for (int i = cx - 1; i <= cx + 1; i++) {
+			if (i < 0 || i >= c -> g)
+				continue;
+			int cell = j * c -> g + i;
+			for (vertex_t u = c -> start[cell]; u < c -> start[cell + 1]; u++) {
+				double dx = c -> x[u] - c -> x[v], dy = c -> y[u] - c -> y[v];
+				if (u == v || dx * dx + dy * dy > c -> r2)
+					continue;
+				if (out)
+					out[n] = u;
+				n++;
+			}
+		}
+	}
+	return n;
+}
+
+static int gen_rgg(long long n, double degree, uint64_t seed,
+	edge_t ** xadj, vertex_t ** adj, vertex_t * n_vertex) {
+
+	Cells c;
+	long long n_cell;
+	vertex_t * id, * fill;
+	edge_t * x = NULL;
+	vertex_t * a = NULL;
+	double r;
+
+	if (n < 1 || n > INT_MAX || !(degree > 0))
+		return -1;
+
+	// cells at least as wide as the radius, and not many more of them than points
+	r = sqrt(degree / (M_PI * n));
+	c.g = r >= 1 ? 1 : (int) fmin(1 / r, sqrt((double) n));
+	if (c.g < 1)
+		c.g = 1;
+	c.r2 = r * r;
+	n_cell = (long long) c.g * c.g;
+
+	c.start = (vertex_t * ) calloc((size_t) n_cell + 1, sizeof(vertex_t));
+	fill = (vertex_t * ) malloc(sizeof(vertex_t) * (size_t) n_cell);
+	id = (vertex_t * ) malloc(sizeof(vertex_t) * (size_t) n);
+	c.x = (double * ) malloc(sizeof(double) * (size_t) n);
+	c.y = (double * ) malloc(sizeof(double) * (size_t) n);
+	if (!c.start || !fill || !id || !c.x || !c.y)
+		goto done;
+
+	// counting sort of the points by cell, each cell then sorted by point so threads do not matter
+	#pragma omp parallel for schedule(static)
+	for (vertex_t i = 0; i < n; i++) {
+		int cell = cell_of(point_coord(seed, i, 0), c.g) +
+			c.g * cell_of(point_coord(seed, i, 1), c.g);
+		#pragma omp atomic
+		c.start[cell + 1]++;
+	}
+	for (long long k = 0; k < n_cell; k++)
+		c.start[k + 1] += c.start[k];
+	memcpy(fill, c.start, sizeof(vertex_t) * (size_t) n_cell);
+
+	#pragma omp parallel for schedule(static)
+	for (vertex_t i = 0; i < n; i++) {
+		int cell = cell_of(point_coord(seed, i, 0), c.g) +
+			c.g * cell_of(point_coord(seed, i, 1), c.g);
+		vertex_t pos;
+		#pragma omp atomic capture
+		pos = fill[cell]++;
+		id[pos] = i;
+	}
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (long long k = 0; k < n_cell; k++) {
+		qsort(id + c.start[k], c.start[k + 1] - c.start[k], sizeof(vertex_t), cmp_vertex);
+		for (vertex_t v = c.start[k]; v < c.start[k + 1]; v++) {
+			c.x[v] = point_coord(seed, id[v], 0);
+			c.y[v] = point_coord(seed, id[v], 1);
+		}
+	}
+
+	x = (edge_t * ) malloc(sizeof(edge_t) * ((size_t) n + 1));
+	if (!x)
+		goto done;
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (vertex_t v = 0; v < n; v++)
+		x[v + 1] = rgg_row( & c, v, NULL);
+
+	a = row_offsets(x, (vertex_t) n) == 0 ? (vertex_t * ) malloc(sizeof(vertex_t) * ((size_t) x[n] + 1)) : NULL;
+	if (!a) {
+		free(x);
+		x = NULL;
+		goto done;
+	}
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (vertex_t v = 0; v < n; v++)
+		rgg_row( & c, v, a + x[v]);
+
+done:
+	free(c.start);
+	free(fill);
+	free(id);
+	free(c.x);
+	free(c.y);
+	if (!x)
+		return -1;
+	* xadj = x;
+	* adj = a;
+	* n_vertex = (vertex_t) n;
+	return 0;
+}
+
+static const char * gen_names[] = {"rmat:", "grid2d:", "grid3d:", "rgg:"};
+
+int is_gen_spec(const char * spec) {
+	for (int i = 0; i < 4; i++)
+		if (strncmp(spec, gen_names[i], strlen(gen_names[i])) == 0)
+			return 1;
+	return 0;
+}
+
+int gen_graph(const char * spec, edge_t ** xadj, vertex_t ** adj, vertex_t * n_vertex) {
+	// up to four numeric fields after the name
+	double f[4];
+	int n_field = 0;
+	const char * p = strchr(spec, ':');
+
+	while (p != NULL && * p == ':' && n_field < 4) {
+		char * end;
+		f[n_field++] = strtod(p + 1, & end);
+		if (end == p + 1)
+			return -1;
+		p = end;
+	}
+	if (p == NULL || * p != '\0')
+		return -1;
+
+	if (strncmp(spec, "rmat:", 5) == 0 && (n_field == 2 || n_field == 3))
+		return gen_rmat((int) f[0], (long long) f[1], n_field == 3 ? (uint64_t) f[2] : 1,
+			xadj, adj, n_vertex);
+	if (strncmp(spec, "grid2d:", 7) == 0 && (n_field == 2 || n_field == 3) &&
+		(n_field == 2 || f[2] == 5 || f[2] == 9))
+		return gen_grid((long long) f[0], (long long) f[1], 1, n_field == 3 && f[2] == 9,
+			xadj, adj, n_vertex);
+	if (strncmp(spec, "grid3d:", 7) == 0 && (n_field == 3 || n_field == 4) &&
+		(n_field == 3 || f[3] == 7 || f[3] == 27))
+		return gen_grid((long long) f[0], (long long) f[1], (long long) f[2], n_field == 4 && f[3] == 27,
+			xadj, adj, n_vertex);
+	if (strncmp(spec, "rgg:", 4) == 0 && (n_field == 2 || n_field == 3))
+		return gen_rgg((long long) f[0], f[1], n_field == 3 ? (uint64_t) f[2] : 1,
+			xadj, adj, n_vertex);
+	return -1;
+}
@@ -0,0 +1,33 @@
+#include "graph.h"
+
+#ifndef GEN_H
+#define GEN_H
+
+/*
+ * Synthetic graphs, generated in parallel straight into CSR.
+ * A spec names a generator and its parameters separated by colons:
+ *
+ *   rmat:SCALE:EDGE_FACTOR[:SEED]     R-MAT / Kronecker with the Graph500 probabilities
+ *                                     (0.57, 0.19, 0.19), 2^SCALE vertices and
+ *                                     EDGE_FACTOR * 2^SCALE generated edges, ids scrambled
+ *   grid2d:NX:NY[:POINTS]             2D stencil, 5 (default) or 9 points
+ *   grid3d:NX:NY:NZ[:POINTS]          3D stencil, 7 (default) or 27 points
+ *   rgg:N:DEGREE[:SEED]               random geometric graph, N points in the unit square
+ *                                     joined within the radius giving DEGREE neighbors
+ *                                     on average, ids in spatial order
+ *
+ * Graphs are undirected without self loops, rows come out sorted and free of
+ * duplicates. The same spec gives the same graph for any number of threads.
+ * Every generator counts the rows in a first pass and fills them in a second,
+ * so the peak memory is the CSR itself. Stencils and geometric graphs are
+ * written row by row. R-MAT generates its edges twice, scatters them into the
+ * rows and merges the duplicates in place, holding them until then.
+ */
+
+/* 1 if path is a generator spec rather than a file */
+int is_gen_spec(const char * spec);
+
+/* generate the graph of a spec, returns -1 on a bad spec, on overflow of edge_t or out of memory */
+int gen_graph(const char * spec, edge_t ** xadj, vertex_t ** adj, vertex_t * n_vertex);
+
+#endif
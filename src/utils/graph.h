@@ -1,9 +1,19 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#define vertex_t int
-#define edge_t unsigned int
-#define eweight_t double
-#define vweight_t int
+/*
+ * Index and weight types of the CSR graph.
+ * Vertex ids are 32-bit to save bandwidth in the coloring kernels, edge offsets
+ * into the adjacency array become 64-bit when built with -DEDGE64, which is needed
+ * once a graph has more than 2^32 stored nonzeros.
+ */
+typedef int vertex_t;
+#ifdef EDGE64
+typedef unsigned long long edge_t;
+#else
+typedef unsigned int edge_t;
+#endif
+typedef double eweight_t;
+typedef int vweight_t;
 
 #endif
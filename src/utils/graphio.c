@@ -2,34 +2,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
 #include "mmio.h"
+#include "csr.h"
+#include "gen.h"
 #include "graphio.h"
 
-
-typedef struct {
-	// src
-	vertex_t u;
-	// dest
-	vertex_t v;
-	// weight
-	eweight_t w;
-}
-Edge;
-
-int cmp(const void * a, const void * b) {
-	const vertex_t * ia = (const vertex_t * ) a;
-	const vertex_t * ib = (const vertex_t * ) b;
-	return * ia - * ib;
-}
-
-int tricmp(const void * t1, const void * t2) {
-	Edge * tr1 = (Edge * ) t1;
-	Edge * tr2 = (Edge * ) t2;
-	if (tr1 -> u == tr2 -> u) {
-		return (int)(tr1 -> v - tr2 -> v);
-	}
-	return (int)(tr1 -> u - tr2 -> u);
-}
+#ifdef EDGE64
+#define CACHE_EXT "e64.bin"
+#else
+#define CACHE_EXT "bin"
+#endif
 
 int ends_with(const char * str, const char * suffix) {
 	if (!str || !suffix) return 0;
@@ -39,6 +27,22 @@ int ends_with(const char * str, const char * suffix) {
 	return (strncmp(str + lenstr - lensuffix, suffix, lensuffix) == 0);
 }
 
+/* mm_read_mtx_crd_size with a nonzero count wide enough for edge_t */
+int read_crd_size(FILE * fp, vertex_t * M, vertex_t * N, edge_t * nz) {
+	char line[MM_MAX_LINE_LENGTH];
+	long long n_nz;
+
+	do {
+		if (fgets(line, MM_MAX_LINE_LENGTH, fp) == NULL)
+			return MM_PREMATURE_EOF;
+	} while (line[0] == '%');
+
+	if (sscanf(line, "%d %d %lld", M, N, & n_nz) != 3 || n_nz < 0)
+		return MM_PREMATURE_EOF;
+	* nz = (edge_t) n_nz;
+	return 0;
+}
+
 int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 	eweight_t ** ew, vweight_t ** vw,
 	vertex_t * n_vertex, int loop) {
@@ -46,8 +50,12 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 	int state = 0, fmt = 0, ncon = 1, i;
 	vertex_t num_vertex = -1, vcount = 0, jv;
 	edge_t num_edge = -1, ecount = 0;
+	eweight_t weight;
+	Coo coo;
 	char * temp, * graphLine = (char * ) malloc(sizeof(char) * 10000000 + 1);
 
+	memset( & coo, 0, sizeof(Coo));
+
 	while (fgets(graphLine, 10000000, fp) != NULL) {
 		for (i = 0; i < (int) strlen(graphLine); i++) {
 			char c = graphLine[i];
@@ -64,7 +72,7 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 			num_vertex = atoi(temp);
 
 			temp = strtok(NULL, " \t\n");
-			num_edge = atoi(temp);
+			num_edge = strtoull(temp, NULL, 10);
 
 			temp = strtok(NULL, " \t\n");
 			if (temp != NULL) {
@@ -76,12 +84,9 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 			}
 
 			* n_vertex = num_vertex;
-			( * xadj) = (edge_t * ) malloc(sizeof(edge_t) * (num_vertex + 1));
-			( * xadj)[0] = 0;
-
-			( * vw) = (vweight_t * ) malloc(sizeof(vweight_t) * num_vertex);
-			( * adj) = (vertex_t * ) malloc(sizeof(vertex_t) * 2 * num_edge);
-			( * ew) = (eweight_t * ) malloc(sizeof(eweight_t) * 2 * num_edge);
+			if (vw)
+				( * vw) = (vweight_t * ) malloc(sizeof(vweight_t) * num_vertex);
+			coo.weighted = ew != NULL;
 
 			state = 1;
 		} else {
@@ -97,11 +102,12 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 			}
 
 			if (fmt % 100 >= 10) {
-				( * vw)[vcount] = atoi(temp);
+				if (vw)
+					( * vw)[vcount] = atoi(temp);
 				for (i = 1; i < ncon; i++) {
 					temp = strtok(NULL, " \t\n");
 				}
-			} else {
+			} else if (vw) {
 				( * vw)[vcount] = 1;
 			}
 
@@ -111,30 +117,38 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 					return -1;
 				}
 
-				( * adj)[ecount] = atoi(temp) - 1;
-				if (( * adj)[ecount] == vcount && !loop) {
-					continue;
-				}
-
+				jv = atoi(temp) - 1;
 				temp = strtok(NULL, " \t\n");
 				if (fmt % 10 == 1) {
-					( * ew)[ecount] = atoi(temp);
+					weight = atoi(temp);
 					temp = strtok(NULL, " \t\n");
 				} else {
-					( * ew)[ecount] = 1;
+					weight = 1;
+				}
+
+				if (jv < 0 || jv >= num_vertex) {
+					fprintf(stderr, "neighbor %ld of %ld out of range.\n", (long) jv + 1, (long) vcount + 1);
+					return -1;
+				}
+				if (weight < 0) {
+					fprintf(stderr, "negative edge weight %lf at (%ld,%ld).\n", weight, (long) vcount, (long) jv);
+					return -1;
+				}
+				if (jv == vcount && !loop) {
+					continue;
 				}
 
-				if (( * ew)[ecount] < 0) {
-					fprintf(stderr, "negative edge weight %lf at (%ld,%ld).\n", ( * ew)[ecount], (long) vcount, (long)(( * adj)[ecount]));
+				if (coo_push( & coo, vcount, jv, weight) != 0) {
+					fprintf(stderr, "fail to allocate edges.\n");
 					return -1;
 				}
 				ecount++;
 			}
 
 			vcount++;
-			( * xadj)[vcount] = ecount;
 		}
 	}
+	free(graphLine);
 
 	if (vcount != num_vertex) {
 		fprintf(stderr, "num vertex %ld != %ld.\n", (long) num_vertex, (long) vcount);
@@ -143,40 +157,110 @@ int read_chaco(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 
 	if (ecount != 2 * num_edge) {
 		fprintf(stderr, "num edge %ld != %ld.\n", (long) ecount, (long)(2 * num_edge));
-		( * adj) = (vertex_t * ) realloc(( * adj), sizeof(vertex_t) * ecount);
-		( * ew) = (eweight_t * ) realloc(( * ew), sizeof(eweight_t) * ecount);
 	}
 
-	for (jv = 0; jv < vcount; jv++) {
-		qsort(( * adj) + ( * xadj)[jv], ( * xadj)[jv + 1] - ( * xadj)[jv], sizeof(vertex_t), cmp);
+	// both directions are listed, so no mirroring
+	if (build_csr( & coo, 1, num_vertex, 0, xadj, adj, ew) != 0) {
+		fprintf(stderr, "fail to allocate csr.\n");
+		coo_free( & coo);
+		return -1;
 	}
 
 	return 1;
 }
 
+/* skip blanks within a line */
+static const char * skip_blank(const char * p, const char * end) {
+	while (p < end && (* p == ' ' || * p == '\t' || * p == '\r'))
+		p++;
+	return p;
+}
+
+/* hand-rolled integer parser, returns NULL if there is no digit */
+static const char * parse_int(const char * p, const char * end, long long * out) {
+	long long x = 0;
+	int neg = 0;
+
+	p = skip_blank(p, end);
+	if (p < end && (* p == '-' || * p == '+'))
+		neg = * p++ == '-';
+	if (p >= end || * p < '0' || * p > '9')
+		return NULL;
+	while (p < end && * p >= '0' && * p <= '9')
+		x = x * 10 + (* p++ - '0');
+	* out = neg ? -x : x;
+	return p;
+}
+
+/* decimal and scientific notation, not correctly rounded in the last bits */
+static const char * parse_real(const char * p, const char * end, double * out) {
+	double x = 0, scale = 1;
+	long long e = 0;
+	int neg = 0, digits = 0;
+
+	p = skip_blank(p, end);
+	if (p < end && (* p == '-' || * p == '+'))
+		neg = * p++ == '-';
+	while (p < end && * p >= '0' && * p <= '9') {
+		x = x * 10 + (* p++ - '0');
+		digits++;
+	}
+	if (p < end && * p == '.') {
+		p++;
+		while (p < end && * p >= '0' && * p <= '9') {
+			scale *= 0.1;
+			x += (* p++ - '0') * scale;
+			digits++;
+		}
+	}
+	if (!digits)
+		return NULL;
+	if (p < end && (* p == 'e' || * p == 'E')) {
+		const char * q = parse_int(p + 1, end, & e);
+		if (q != NULL) {
+			p = q;
+			x *= pow(10.0, (double) e);
+		}
+	}
+	* out = neg ? -x : x;
+	return p;
+}
+
+/* the line after p, or end */
+static const char * next_line(const char * p, const char * end) {
+	const char * nl = (const char * ) memchr(p, '\n', end - p);
+	return nl ? nl + 1 : end;
+}
+
+/*
+ * Parse the entries of a matrix market file in parallel.
+ * The file is mapped and split at line boundaries, one chunk per thread,
+ * every thread parses its chunk into its own coordinate buffer.
+ */
 int read_mtx(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 	eweight_t ** ew, vweight_t ** vw,
 	vertex_t * n_vertex, int loop, int offset) {
 
-	Edge * edge;
 	// lower bound and upper bound
 	vertex_t l, r;
-	vertex_t u, v;
-	vertex_t M, N, wi;
-	eweight_t w;
-	int n_edge, curr_edge;
-	edge_t k;
-
+	vertex_t M, N;
+	edge_t n_edge;
 	MM_typecode matcode;
+	struct stat st;
+	const char * data;
+	long data_start;
+	int n_part, status = 0;
+	edge_t n_parsed = 0;
+	Coo * part;
 
 	if (mm_read_banner(fp, & matcode) != 0) 
 	{
 		fprintf(stderr, "fail at mm_read_banner.\n");
 		return -1;
 	}
-	if (mm_read_mtx_crd_size(fp, & M, & N, & n_edge) != 0) 
+	if (read_crd_size(fp, & M, & N, & n_edge) != 0) 
 	{
-		fprintf(stderr, "fail at mm_read_mtx_crd_size.\n");
+		fprintf(stderr, "fail at read_crd_size.\n");
 		return -1;
 	}
 	if (M != N) 
@@ -190,162 +274,331 @@ int read_mtx(FILE * fp, edge_t ** xadj, vertex_t ** adj,
 	l = 1 - offset;
 	r = N - offset;
 
-	edge = (Edge * ) malloc(2 * n_edge * sizeof(Edge));
-	curr_edge = 0;
-	if (mm_is_pattern(matcode)) 
+	data_start = ftell(fp);
+	if (data_start < 0 || fstat(fileno(fp), & st) != 0)
+	{
+		fprintf(stderr, "fail to stat matrix file.\n");
+		return -1;
+	}
+	if (st.st_size <= data_start)
 	{
-		for (edge_t i = 0; i < n_edge; i++) {
-			fscanf(fp, "%d %d\n", & u, & v);
+		fprintf(stderr, "matrix file has no entries.\n");
+		return -1;
+	}
 
-			if (u < l || v < l || u > r || v > r) {
-				fprintf(stderr, 
-					"coord (%ld,%ld) not in range [%ld,%ld].\n", 
-					(long) u, (long) v, (long) l, (long) r);
-				return -1;
-			}
+	data = (const char * ) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "fail to map matrix file.\n");
+		return -1;
+	}
+	madvise((void * ) data, st.st_size, MADV_SEQUENTIAL);
 
-			if (loop || u != v) {
-				edge[curr_edge].u = u;
-				edge[curr_edge].v = v;
-				edge[curr_edge].w = 1;
-				curr_edge++;
-				if (mm_is_symmetric(matcode) && u != v) {
-					edge[curr_edge].u = edge[curr_edge - 1].v;
-					edge[curr_edge].v = edge[curr_edge - 1].u;
-					edge[curr_edge].w = edge[curr_edge - 1].w;
-					curr_edge++;
-				}
-			}
-		}
-	} else {
-		for (edge_t i = 0; i < n_edge; i++) {
-			if (mm_is_real(matcode))
-				fscanf(fp, "%d %d %lf\n", & u, & v, & w);
-			else if (mm_is_integer(matcode))
-				fscanf(fp, "%d %d %d\n", & u, & v, & wi);
+	n_part = omp_get_max_threads();
+	part = (Coo * ) calloc(n_part, sizeof(Coo));
+	for (int t = 0; t < n_part; t++)
+		part[t].weighted = ew != NULL;
 
-			w = (double) wi;
+	#pragma omp parallel num_threads(n_part)
+	{
+		int t = omp_get_thread_num();
+		int pattern = mm_is_pattern(matcode);
+		int real = mm_is_real(matcode) || mm_is_complex(matcode);
+		size_t len = st.st_size - data_start;
+		const char * end = data + st.st_size;
+		const char * p = data + data_start + len * t / n_part;
+		const char * stop = data + data_start + len * (t + 1) / n_part;
+		int failed = 0;
+		edge_t n_entry = 0;
+
+		// a chunk owns every line that starts inside it
+		if (t > 0 && p[-1] != '\n')
+			p = next_line(p, end);
+		if (t < n_part - 1 && stop[-1] != '\n')
+			stop = next_line(stop, end);
+
+		while (p < stop && !failed) {
+			const char * q;
+			long long u, v, wi;
+			double w = 1;
+
+			q = parse_int(p, stop, & u);
+			if (q == NULL) {
+				// blank line
+				p = next_line(p, stop);
+				continue;
+			}
+			q = parse_int(q, stop, & v);
+			if (q != NULL && !pattern) {
+				if (real)
+					q = parse_real(q, stop, & w);
+				else if ((q = parse_int(q, stop, & wi)) != NULL)
+					w = (double) wi;
+			}
+			if (q == NULL) {
+				fprintf(stderr, "malformed entry in matrix file.\n");
+				failed = 1;
+				break;
+			}
+			p = next_line(q, stop);
+			n_entry++;
 
 			if (u < l || v < l || u > r || v > r) {
 				fprintf(stderr, 
 					"coord (%ld,%ld) not in range [%ld,%ld].\n", 
 					(long) u, (long) v, (long) l, (long) r);
-				return -1;
+				failed = 1;
+				break;
 			}
 
 			if (w != 0 && (loop || u != v)) {
-				edge[curr_edge].u = u;
-				edge[curr_edge].v = v;
-				edge[curr_edge].w = fabs(w);
-				curr_edge++;
-				if (mm_is_symmetric(matcode) && u != v) {
-					edge[curr_edge].u = edge[curr_edge - 1].v;
-					edge[curr_edge].v = edge[curr_edge - 1].u;
-					edge[curr_edge].w = edge[curr_edge - 1].w;
-					curr_edge++;
+				vertex_t ru = (vertex_t)(u - 1 + offset), rv = (vertex_t)(v - 1 + offset);
+				// the mirrored entry of a symmetric matrix is added by build_csr
+				if (coo_push( & part[t], ru, rv, fabs(w)) != 0) {
+					fprintf(stderr, "fail to allocate edges.\n");
+					failed = 1;
 				}
 			}
 		}
-	}
 
-	qsort(edge, curr_edge, sizeof(Edge), tricmp);
+		if (failed) {
+			#pragma omp atomic write
+			status = -1;
+		}
+		#pragma omp atomic
+		n_parsed += n_entry;
+	}
 
-	( * xadj) = (edge_t * ) malloc(sizeof(edge_t) * (N + 1));
-	memset(( * xadj), 0, sizeof(edge_t) * (N + 1));
+	munmap((void * ) data, st.st_size);
 
-	k = 0;
-	( * xadj)[edge[0].u + offset]++;
-	for (edge_t ei = 1; ei < curr_edge; ei++) {
-		u = edge[ei].u;
-		if (u != edge[ei - 1].u || edge[ei].v != edge[ei - 1].v) {
-			// not same as previous
-			( * xadj)[u + offset]++;
-			k = u;
-		} else {
-			edge[k].w += edge[u].w;
-		}
+	// every entry is parsed, skipped ones included, so a truncated or padded file shows here
+	if (status == 0 && n_parsed != n_edge) {
+		fprintf(stderr, "num entry %lld != %lld.\n", (long long) n_parsed, (long long) n_edge);
+		status = -1;
 	}
-	for (u = 2; u <= N; u++)
-		( * xadj)[u] += ( * xadj)[u - 1];
-
-	( * adj) = (vertex_t * ) malloc(sizeof(vertex_t) * ( * xadj)[N]);
-	( * ew) = (eweight_t * ) malloc(sizeof(eweight_t) * ( * xadj)[N]);
-	( * adj)[0] = edge[0].v - 1 + offset;
-	( * ew)[0] = edge[0].w;
-	k = 1;
-
-	for (edge_t ei = 1; ei < curr_edge; ei++) {
-		u = edge[ei].u;
-		if (u != edge[ei - 1].u || edge[ei].v != edge[ei - 1].v) {
-			// not same as previous
-			( * adj)[k] = edge[ei].v - 1 + offset;
-			( * ew)[k++] = edge[ei].w;
-		}
+
+	if (status == 0 && build_csr(part, n_part, N,
+		mm_is_symmetric(matcode) ? CSR_SYMMETRIC : 0, xadj, adj, ew) != 0) {
+		fprintf(stderr, "fail to allocate csr.\n");
+		status = -1;
 	}
+	for (int t = 0; t < n_part; t++)
+		coo_free( & part[t]);
+	free(part);
+	if (status != 0)
+		return -1;
 
-	( * vw) = (vweight_t * ) malloc(sizeof(vweight_t) * N);
-	for (u = 0; u < N; u++)
-		( * vw)[u] = 1;
+	if (vw) {
+		( * vw) = (vweight_t * ) malloc(sizeof(vweight_t) * N);
+		for (vertex_t u = 0; u < N; u++)
+			( * vw)[u] = 1;
+	}
 
-	free(edge);
 	return 0;
 }
 
-int read_cache(FILE * bp, edge_t ** xadj, vertex_t ** adj,
-	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex) {
+/*
+ * Binary cache layout, version 3:
+ * a CacheHeader padded to CACHE_ALIGN bytes, followed by xadj, adj, ew and vw,
+ * each starting at a multiple of CACHE_ALIGN so the file can be mapped and
+ * handed out without copying. The weight sections are optional, a cache
+ * written by a structure-only read ends after adj and has both offsets 0.
+ */
+#define CACHE_MAGIC "GRAPHBIN"
+#define CACHE_VERSION 3
+#define CACHE_ALIGN 4096
+#define CACHE_WEIGHTS 0x1 /* ew and vw sections are present */
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	// sizes of vertex_t, edge_t, eweight_t and vweight_t at write time
+	uint32_t vertex_size, edge_size, eweight_size, vweight_size;
+	uint32_t sections;
+	uint64_t n_vertex, n_edge;
+	uint64_t off_xadj, off_adj, off_ew, off_vw;
+	uint64_t file_size;
+}
+CacheHeader;
+
+/* caches currently mapped by read_cache, so free_graph knows to unmap */
+#define MAX_MAPPINGS 16
+static struct {
+	void * base;
+	size_t length;
+} mappings[MAX_MAPPINGS];
+
+static uint64_t align_up(uint64_t x) {
+	return (x + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+}
+
+static void cache_layout(CacheHeader * h, vertex_t n_vertex, edge_t n_edge, uint32_t sections) {
+	memset(h, 0, sizeof(CacheHeader));
+	memcpy(h -> magic, CACHE_MAGIC, 8);
+	h -> version = CACHE_VERSION;
+	h -> vertex_size = sizeof(vertex_t);
+	h -> edge_size = sizeof(edge_t);
+	h -> eweight_size = sizeof(eweight_t);
+	h -> vweight_size = sizeof(vweight_t);
+	h -> sections = sections;
+	h -> n_vertex = n_vertex;
+	h -> n_edge = n_edge;
+	h -> off_xadj = CACHE_ALIGN;
+	h -> off_adj = align_up(h -> off_xadj + sizeof(edge_t) * (n_vertex + 1));
+	h -> file_size = h -> off_adj + sizeof(vertex_t) * n_edge;
+	if (sections & CACHE_WEIGHTS) {
+		h -> off_ew = align_up(h -> file_size);
+		h -> off_vw = align_up(h -> off_ew + sizeof(eweight_t) * n_edge);
+		h -> file_size = h -> off_vw + sizeof(vweight_t) * n_vertex;
+	}
+}
+
+/*
+ * Map a cache read-only and point into it, the arrays must not be written to.
+ * With GRAPH_STRUCTURE only xadj and adj are mapped, and ew and vw are NULL.
+ * Returns -1 if the file is not a cache of this version and these index types,
+ * or if weights are asked for and the cache has none.
+ */
+int read_cache(int fd, edge_t ** xadj, vertex_t ** adj,
+	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex, int flags) {
+
+	struct stat st;
+	CacheHeader h, expect;
+	char * base;
+	size_t length;
+	int slot, structure = flags & GRAPH_STRUCTURE;
+
+	if (fstat(fd, & st) != 0 || (size_t) st.st_size < sizeof(CacheHeader))
+		return -1;
+	if (pread(fd, & h, sizeof(CacheHeader), 0) != (ssize_t) sizeof(CacheHeader))
+		return -1;
+
+	// the layout is fully determined by the counts, so compare against a fresh one
+	cache_layout( & expect, (vertex_t) h.n_vertex, (edge_t) h.n_edge, h.sections & CACHE_WEIGHTS);
+	if (memcmp( & h, & expect, sizeof(CacheHeader)) != 0 || (uint64_t) st.st_size < h.file_size)
+		return -1;
+	if (!structure && !(h.sections & CACHE_WEIGHTS))
+		return -1;
+
+	// the weight sections come last, a structure-only read leaves them unmapped
+	length = structure ? h.off_adj + sizeof(vertex_t) * h.n_edge : h.file_size;
+
+	for (slot = 0; slot < MAX_MAPPINGS && mappings[slot].base != NULL; slot++);
+	if (slot == MAX_MAPPINGS)
+		return -1;
 
-	fread(n_vertex, sizeof(vertex_t), 1, bp);
+	base = (char * ) mmap(NULL, length, PROT_READ,
+		MAP_SHARED | ((flags & GRAPH_POPULATE) ? MAP_POPULATE : 0), fd, 0);
+	if (base == MAP_FAILED)
+		return -1;
+	if (flags & GRAPH_WILLNEED)
+		madvise(base, length, MADV_WILLNEED);
 
-	( * xadj) = (edge_t * ) malloc(sizeof(edge_t) * ( * n_vertex + 1));
-	fread( * xadj, sizeof(edge_t), (size_t)( * n_vertex + 1), bp);
+	mappings[slot].base = base;
+	mappings[slot].length = length;
 
-	( * adj) = (vertex_t * ) malloc(sizeof(vertex_t) * ( * xadj)[ * n_vertex]);
-	fread( * adj, sizeof(vertex_t), (size_t)( * xadj)[ * n_vertex], bp);
+	* n_vertex = (vertex_t) h.n_vertex;
+	* xadj = (edge_t * )(base + h.off_xadj);
+	* adj = (vertex_t * )(base + h.off_adj);
+	* ew = structure ? NULL : (eweight_t * )(base + h.off_ew);
+	* vw = structure ? NULL : (vweight_t * )(base + h.off_vw);
 
-	( * ew) = (eweight_t * ) malloc(sizeof(eweight_t) * ( * xadj)[ * n_vertex]);
-	fread( * ew, sizeof(eweight_t), (size_t)( * xadj)[ * n_vertex], bp);
+	return 0;
+}
 
-	( * vw) = (vweight_t * ) malloc(sizeof(vweight_t) * ( * n_vertex));
-	fread( * vw, sizeof(vweight_t), * n_vertex, bp);
+static int write_section(FILE * bp, uint64_t offset, const void * data, size_t size) {
+	static const char zeros[CACHE_ALIGN] = {0};
+	long pos = ftell(bp);
 
+	if (pos < 0 || (uint64_t) pos > offset)
+		return -1;
+	if (fwrite(zeros, 1, (size_t)(offset - pos), bp) != (size_t)(offset - pos))
+		return -1;
+	if (size > 0 && fwrite(data, 1, size, bp) != size)
+		return -1;
 	return 0;
 }
 
 int save_cache(FILE * bp, edge_t * xadj, vertex_t * adj,
 	eweight_t * ew, vweight_t * vw, vertex_t n_vertex) {
 
-	fwrite( & n_vertex, sizeof(vertex_t), (size_t) 1, bp);
-	fwrite(xadj, sizeof(edge_t), (size_t)(n_vertex + 1), bp);
-	fwrite(adj, sizeof(vertex_t), (size_t)(xadj[n_vertex]), bp);
-	fwrite(ew, sizeof(eweight_t), (size_t)(xadj[n_vertex]), bp);
-	fwrite(vw, sizeof(vweight_t), (size_t)(n_vertex), bp);
+	CacheHeader h;
+	edge_t n_edge = xadj[n_vertex];
+	cache_layout( & h, n_vertex, n_edge, ew != NULL ? CACHE_WEIGHTS : 0);
+
+	if (write_section(bp, 0, & h, sizeof(CacheHeader)) != 0 ||
+		write_section(bp, h.off_xadj, xadj, sizeof(edge_t) * (n_vertex + 1)) != 0 ||
+		write_section(bp, h.off_adj, adj, sizeof(vertex_t) * n_edge) != 0)
+		return -1;
+	if (ew != NULL && (write_section(bp, h.off_ew, ew, sizeof(eweight_t) * n_edge) != 0 ||
+		write_section(bp, h.off_vw, vw, sizeof(vweight_t) * n_vertex) != 0))
+		return -1;
 
 	return 0;
 }
 
+void free_graph(edge_t * xadj, vertex_t * adj, eweight_t * ew, vweight_t * vw) {
+	for (int slot = 0; slot < MAX_MAPPINGS; slot++) {
+		char * base = (char * ) mappings[slot].base;
+		if (base != NULL && (char * ) xadj >= base && (char * ) xadj < base + mappings[slot].length) {
+			munmap(base, mappings[slot].length);
+			mappings[slot].base = NULL;
+			return;
+		}
+	}
+
+	free(xadj);
+	free(adj);
+	free(ew);
+	free(vw);
+}
+
 int read_graph(char * gpath, edge_t ** xadj, vertex_t ** adj,
-	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex, int loop) {
+	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex, int loop, int flags) {
 
 	char bpath[1024];
-	FILE * bp, * fp;
+	FILE * fp;
+	int fd;
 	// read status
 	int status = 0;
 
-	// read from binary cache, if possible
-	sprintf(bpath, "%s.bin", gpath);
-	bp = fopen(bpath, "rb");
-	if (bp != NULL) 
-	{
-		status = read_cache(bp, xadj, adj, ew, vw, n_vertex);
-		fclose(bp);
-		if (status == -1)
-		{
-			fprintf(stderr, "fail to read cache.\n");
+	// synthetic graphs are generated every time, write_cache keeps one around
+	if (is_gen_spec(gpath)) {
+		* ew = NULL;
+		* vw = NULL;
+		if (gen_graph(gpath, xadj, adj, n_vertex) != 0) {
+			fprintf(stderr, "fail to generate.\n");
+			return -1;
+		}
+		if (flags & GRAPH_STRUCTURE)
+			return 0;
+		// unweighted, every weight is one
+		* ew = (eweight_t * ) malloc(sizeof(eweight_t) * ((size_t)( * xadj)[ * n_vertex] + 1));
+		* vw = (vweight_t * ) malloc(sizeof(vweight_t) * ((size_t) * n_vertex + 1));
+		if (! * ew || ! * vw) {
+			free_graph( * xadj, * adj, * ew, * vw);
 			return -1;
 		}
+		for (edge_t j = 0; j < ( * xadj)[ * n_vertex]; j++)
+			( * ew)[j] = 1;
+		for (vertex_t v = 0; v < * n_vertex; v++)
+			( * vw)[v] = 1;
 		return 0;
 	}
 
+	// map the binary cache, if possible
+	// the layout depends on the width of edge_t, so each width has its own cache
+	sprintf(bpath, "%s.%s", gpath, CACHE_EXT);
+	fd = open(bpath, O_RDONLY);
+	if (fd >= 0) 
+	{
+		status = read_cache(fd, xadj, adj, ew, vw, n_vertex, flags);
+		close(fd);
+		if (status == 0)
+			return 0;
+		fprintf(stderr, "stale or unreadable cache, rebuilding it.\n");
+	}
+
 	// no binary, read from raw and save a cache
 	fp = fopen(gpath, "r");
 	if (fp == NULL) 
@@ -354,12 +607,18 @@ int read_graph(char * gpath, edge_t ** xadj, vertex_t ** adj,
 		return -1;
 	}
 
+	// a structure-only read never allocates the weights
+	* ew = NULL;
+	* vw = NULL;
+	eweight_t ** pew = (flags & GRAPH_STRUCTURE) ? NULL : ew;
+	vweight_t ** pvw = (flags & GRAPH_STRUCTURE) ? NULL : vw;
+
 	if (ends_with(gpath, ".mtx"))
-		status = read_mtx(fp, xadj, adj, ew, vw, n_vertex, loop, 0);
+		status = read_mtx(fp, xadj, adj, pew, pvw, n_vertex, loop, 0);
 	else if (ends_with(gpath, ".txt"))
-		status = read_mtx(fp, xadj, adj, ew, vw, n_vertex, loop, 1);
+		status = read_mtx(fp, xadj, adj, pew, pvw, n_vertex, loop, 1);
 	else if (ends_with(gpath, ".graph"))
-		status = read_chaco(fp, xadj, adj, ew, vw, n_vertex, loop);
+		status = read_chaco(fp, xadj, adj, pew, pvw, n_vertex, loop);
 	else
 		status = -1;
 
@@ -371,17 +630,34 @@ int read_graph(char * gpath, edge_t ** xadj, vertex_t ** adj,
 	}
 
 	// write to binary cache, so next time its faster
-	bp = fopen(bpath, "wb");
-	if (bp != NULL) 
-	{
-		status = save_cache(bp, *xadj, *adj, *ew, *vw, *n_vertex);
-		fclose(bp);
-	}
-	if (bp == NULL || status == -1)
+	if (write_cache(gpath, *xadj, *adj, *ew, *vw, *n_vertex) == -1)
 	{
 		fprintf(stderr, "fail to save cache.\n");
 		return -1;
 	}
 
 	return 0;
+}
+
+int write_cache(char * gpath, edge_t * xadj, vertex_t * adj,
+	eweight_t * ew, vweight_t * vw, vertex_t n_vertex) {
+
+	char bpath[1024], tpath[1100];
+	FILE * bp;
+	int status = -1;
+
+	// written aside and renamed, other processes may still have the old one mapped
+	sprintf(bpath, "%s.%s", gpath, CACHE_EXT);
+	sprintf(tpath, "%s.%ld.tmp", bpath, (long) getpid());
+	bp = fopen(tpath, "wb");
+	if (bp != NULL) 
+	{
+		status = save_cache(bp, xadj, adj, ew, vw, n_vertex);
+		if (fclose(bp) != 0 || status == -1 || rename(tpath, bpath) != 0)
+		{
+			status = -1;
+			remove(tpath);
+		}
+	}
+	return status;
 }
\ No newline at end of file
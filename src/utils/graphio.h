@@ -5,7 +5,29 @@
 #ifndef GRAPHIO_H
 #define GRAPHIO_H
 
+/* read_graph flags, hints for mapping the binary cache */
+#define GRAPH_POPULATE 0x1 /* prefault the whole cache with MAP_POPULATE */
+#define GRAPH_WILLNEED 0x2 /* start readahead with madvise(MADV_WILLNEED) */
+#define GRAPH_STRUCTURE 0x4 /* skip edge and vertex weights, ew and vw come back NULL */
+
+/*
+ * Read a graph into CSR, from the binary cache next to gpath when there is one.
+ * A cached graph is mapped read-only and shared with other processes, its
+ * arrays must not be written to. Release with free_graph either way.
+ * A cache written by a structure-only read has no weights, a later read
+ * that wants them rebuilds it. A generator spec such as rmat:20:16 instead of
+ * a path generates the graph in memory, see gen.h.
+ */
 int read_graph(char * gpath, edge_t ** xadj, vertex_t ** adj,
-	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex, int loop);
+	eweight_t ** ew, vweight_t ** vw, vertex_t * n_vertex, int loop, int flags);
+
+/*
+ * Write the binary cache read_graph maps for gpath, the file at gpath itself
+ * need not exist. Rows must be sorted, ew and vw are either both NULL or both set.
+ */
+int write_cache(char * gpath, edge_t * xadj, vertex_t * adj,
+	eweight_t * ew, vweight_t * vw, vertex_t n_vertex);
+
+void free_graph(edge_t * xadj, vertex_t * adj, eweight_t * ew, vweight_t * vw);
 
 #endif
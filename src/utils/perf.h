@@ -0,0 +1,207 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/**
+ * @brief Hardware counters of every thread of the process, read through perf_event_open
+ *
+ * Counters are opened on each thread listed in /proc/self/task, so the OpenMP pool has
+ * to be up by then, once ahead of the measured runs since opening them costs a system
+ * call per thread and event. Each start and stop then only toggles them, and what was
+ * counted in between is summed over threads. Only user
+ * space is counted, which perf_event_paranoid <= 2 allows without privileges.
+ * An event the machine does not support reads as -1, the others keep working.
+ */
+class PerfCounters
+{
+public:
+	enum
+	{
+		CYCLES,
+		INSTRUCTIONS,
+		LLC_MISSES,
+		DTLB_MISSES,
+		N_EVENT
+	};
+
+	~PerfCounters() { close_all(); }
+
+	/**
+	 * @brief Open the counters, disabled, on every thread
+	 *
+	 * @return false if not even the cycle counter can be opened, see error()
+	 */
+	bool open()
+	{
+		close_all();
+		std::vector<pid_t> tids = threads();
+		for (int e = 0; e < N_EVENT; e++)
+		{
+			for (pid_t tid : tids)
+			{
+				int fd = open_event(e, tid);
+				if (fd < 0)
+				{
+					// a thread may have exited since it was listed, an event may be unsupported
+					if (errno == ESRCH)
+						continue;
+					if (e == CYCLES)
+					{
+						err = std::string("perf_event_open: ") + strerror(errno);
+						close_all();
+						return false;
+					}
+					for (int f : fds[e])
+						close(f);
+					fds[e].clear();
+					break;
+				}
+				fds[e].push_back(fd);
+				base[e].push_back({0, 0, 0});
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Enable the opened counters
+	 */
+	void start()
+	{
+		for (int e = 0; e < N_EVENT; e++)
+			for (size_t i = 0; i < fds[e].size(); i++)
+				read_counter(fds[e][i], base[e][i]);
+
+		for (int e = 0; e < N_EVENT; e++)
+			for (int fd : fds[e])
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+
+	/**
+	 * @brief Disable the counters and read what they counted since start, they stay open
+	 *
+	 * @param value: output counts summed over threads and scaled for multiplexing, -1 if unsupported
+	 */
+	void stop(long long value[N_EVENT])
+	{
+		for (int e = 0; e < N_EVENT; e++)
+			for (int fd : fds[e])
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+		for (int e = 0; e < N_EVENT; e++)
+		{
+			value[e] = fds[e].empty() ? -1 : 0;
+			for (size_t i = 0; i < fds[e].size(); i++)
+			{
+				sample now;
+				if (!read_counter(fds[e][i], now))
+					continue;
+				const sample &then = base[e][i];
+				uint64_t running = now.running - then.running;
+				if (running == 0)
+					continue;
+				value[e] += (long long)((double)(now.count - then.count) * (now.enabled - then.enabled) / running);
+			}
+		}
+	}
+
+	/**
+	 * @brief Why open() failed
+	 */
+	const std::string &error() const { return err; }
+
+private:
+	// count, time enabled, time running, all cumulative since the counter was opened
+	struct sample
+	{
+		uint64_t count, enabled, running;
+	};
+
+	std::vector<int> fds[N_EVENT];
+	std::vector<sample> base[N_EVENT];
+	std::string err;
+
+	void close_all()
+	{
+		for (int e = 0; e < N_EVENT; e++)
+		{
+			for (int fd : fds[e])
+				close(fd);
+			fds[e].clear();
+			base[e].clear();
+		}
+	}
+
+	static bool read_counter(int fd, sample &s)
+	{
+		uint64_t buf[3];
+		if (read(fd, buf, sizeof(buf)) != sizeof(buf))
+			return false;
+		s = {buf[0], buf[1], buf[2]};
+		return true;
+	}
+
+	static std::vector<pid_t> threads()
+	{
+		std::vector<pid_t> tids;
+		DIR *dir = opendir("/proc/self/task");
+		if (dir == nullptr)
+		{
+			tids.push_back(0);
+			return tids;
+		}
+		while (struct dirent *entry = readdir(dir))
+			if (entry->d_name[0] != '.')
+				tids.push_back((pid_t)atoi(entry->d_name));
+		closedir(dir);
+		return tids;
+	}
+
+	static int open_event(int e, pid_t tid)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (e)
+		{
+		case CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case INSTRUCTIONS:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case LLC_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+						  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		default:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+						  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		}
+		return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0);
+	}
+};
+
+#endif
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Driver check on a generated graph: -B leaves no conflict and never adds colors.
+# Jones-Plassmann colors the same for any number of threads, so the runs with and
+# without -B compare row by row.
+spec=${1:-rmat:12:8:3}
+plain=$(mktemp)
+balanced=$(mktemp)
+trap 'rm -f "$plain" "$balanced"' EXIT
+
+./coloring -d 1 -a jp -t 1,2,4 -f csv "$spec" > "$plain" 2> /dev/null &&
+	./coloring -d 1 -a jp -t 1,2,4 -B -f csv "$spec" > "$balanced" 2> /dev/null || {
+	echo " FAIL running ./coloring on $spec"
+	exit 1
+}
+
+# method, n_threads, n_colors and n_conf are columns 1, 2, 4 and 6 of the csv
+awk -F, -v spec="$spec" '
+	FNR == 1 { next }
+	NR == FNR { colors[$1 "," $2] = $4; next }
+	{
+		run = $1 " on " $2 " threads"
+		if ($6 != 0) { printf " FAIL %s: %s left %d conflicts with -B\n", spec, run, $6; failed = 1 }
+		if ($4 > colors[$1 "," $2]) { printf " FAIL %s: %s has %d colors with -B, %d without\n", spec, run, $4, colors[$1 "," $2]; failed = 1 }
+		n++
+	}
+	END {
+		if (n == 0) { printf " FAIL %s: no run\n", spec; exit 1 }
+		if (!failed) printf " ok   -B adds no color and leaves no conflict over %d runs of %s\n", n, spec
+		exit failed
+	}' "$plain" "$balanced"
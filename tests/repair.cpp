@@ -0,0 +1,130 @@
+/**
+ * Checks of the library on a generated graph: balancing and repair keep the coloring valid
+ * and never need more colors than the coloring they start from.
+ *
+ * Distance 1 with Jones-Plassmann, which colors the same whatever the number of threads.
+ * Edges are inserted between vertices of the same color, so every one of them is a conflict,
+ * and only between vertices left with fewer neighbors than colors, so that first fit always
+ * finds one of the colors already in use. Vertices are appended with as few neighbors.
+ */
+#include "libcoloring.h"
+#include "utils/gen.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int n_failed = 0;
+
+static void expect(bool ok, const char *what)
+{
+	printf(" %s %s\n", ok ? "ok  " : "FAIL", what);
+	if (!ok)
+		n_failed++;
+}
+
+int main()
+{
+	const char *spec = "rmat:12:8:3";
+	const vertex_t n_added = 16;
+	const int max_insert = 64;
+
+	edge_t *xadj;
+	vertex_t *adj, n_vertex;
+	if (gen_graph(spec, &xadj, &adj, &n_vertex) != 0)
+	{
+		printf(" FAIL generating %s\n", spec);
+		return EXIT_FAILURE;
+	}
+
+	coloring_options opt;
+	coloring_options_init(&opt);
+	opt.distance = 1;
+	opt.algorithm = COLORING_JONES_PLASSMANN;
+
+	std::vector<int> colormap;
+	coloring_result plain, balanced;
+	int n_color;
+	{
+		Coloring::Graph g(n_vertex, xadj, adj);
+		plain = g.color(colormap, opt);
+		opt.balance = 1;
+		balanced = g.color(colormap, opt);
+		n_color = balanced.n_color;
+
+		expect(plain.n_conflict == 0, "coloring has no conflict");
+		expect(balanced.n_color <= plain.n_color, "balancing adds no color");
+		expect(balanced.n_conflict == 0 && coloring_check(g.handle(), 1, colormap.data()) == 0,
+			   "balanced coloring has no conflict");
+		expect(balanced.class_imbalance <= plain.class_imbalance, "balancing evens out the classes");
+	}
+
+	// the graph after the change, as adjacency lists
+	std::vector<std::vector<vertex_t>> rows(n_vertex + n_added);
+	for (vertex_t v = 0; v < n_vertex; v++)
+		rows[v].assign(adj + xadj[v], adj + xadj[v + 1]);
+
+	// one inserted edge per vertex at most, between vertices of the same color that keep fewer neighbors than colors
+	std::vector<vertex_t> inserted, waiting(n_color, -1);
+	std::vector<char> used(n_vertex);
+	for (vertex_t v = 0; v < n_vertex && (int)inserted.size() < 2 * max_insert; v++)
+	{
+		if ((vertex_t)rows[v].size() + 1 >= n_color)
+			continue;
+		int c = colormap[v];
+		if (waiting[c] < 0)
+		{
+			waiting[c] = v;
+			continue;
+		}
+		vertex_t u = waiting[c];
+		waiting[c] = -1;
+		rows[u].push_back(v);
+		rows[v].push_back(u);
+		used[u] = used[v] = 1;
+		inserted.push_back(u);
+		inserted.push_back(v);
+	}
+
+	// appended vertices, each joined to three old vertices not touched otherwise
+	vertex_t next = n_vertex - 1;
+	for (vertex_t a = n_vertex; a < n_vertex + n_added; a++)
+		for (int k = 0; k < 3; k++)
+		{
+			while (next >= 0 && (used[next] || (vertex_t)rows[next].size() + 1 >= n_color))
+				next--;
+			if (next < 0)
+				break;
+			used[next] = 1;
+			rows[a].push_back(next);
+			rows[next].push_back(a);
+		}
+
+	std::vector<edge_t> xadj2(n_vertex + n_added + 1);
+	std::vector<vertex_t> adj2;
+	for (vertex_t v = 0; v < n_vertex + n_added; v++)
+	{
+		std::sort(rows[v].begin(), rows[v].end());
+		adj2.insert(adj2.end(), rows[v].begin(), rows[v].end());
+		xadj2[v + 1] = (edge_t)adj2.size();
+	}
+
+	{
+		Coloring::Graph g(n_vertex + n_added, xadj2.data(), adj2.data());
+		long long before = coloring_check(g.handle(), 1, colormap.data());
+		coloring_result r = g.repair(colormap, inserted, n_added, n_color, opt);
+
+		expect(before >= (long long)inserted.size() / 2, "inserted edges are conflicts");
+		expect(r.n_color <= n_color, "repair adds no color");
+		expect(r.n_recolored >= (int)inserted.size() / 2 + n_added, "repair recolors an endpoint of every conflict and the added vertices");
+		expect(r.n_conflict == 0 && coloring_check(g.handle(), 1, colormap.data()) == 0,
+			   "repaired coloring has no conflict");
+		printf("      %s: %d colors, %d after balancing, %zu edges and %d vertices repaired with %d colors, %d recolored\n",
+			   spec, plain.n_color, n_color, inserted.size() / 2, n_added, r.n_color, r.n_recolored);
+	}
+
+	free(xadj);
+	free(adj);
+	return n_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -10,8 +10,10 @@ DEFAULT_COL_NAMES = ["method", "n_threads", "n_fixes", "n_colors", "time", "n_co
 def plot(path: str) -> None:
     name = osp.basename(path).split('.')[0]
     
+    # logs of `./coloring -f csv` are named already, older table logs are named by position
     df = pd.read_csv(path)
-    df.rename(columns=dict(zip(df.columns, DEFAULT_COL_NAMES)), inplace=True)
+    if 'method' not in df.columns:
+        df.rename(columns=dict(zip(df.columns, DEFAULT_COL_NAMES)), inplace=True)
     
     df['speedup'] = df.iloc[1]['time'].min() / df['time']
     seq = df.iloc[0]